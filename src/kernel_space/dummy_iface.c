@@ -13,9 +13,7 @@ static int __init dummy_iface_init(void)
 {
 	DI_TRACE_CALL(err);
 
-	dummy_iface_netlink_init();
-
-	return 0;
+	return dummy_iface_netlink_init();
 }
 
 static void __exit dummy_iface_cleanup(void)
@@ -11,10 +11,27 @@
 #include <linux/if_link.h>
 #include <linux/netdevice.h>
 #include <linux/list.h>
+#include <linux/rcupdate.h>
 #include <linux/types.h>
+#include <linux/u64_stats_sync.h>
+#include <linux/skbuff.h>
+#include <linux/tcp.h>
+#include <linux/if_vlan.h>
+#include <linux/hrtimer.h>
+#include <linux/smp.h>
 
+#include "dummy_iface_uapi.h"
 
+
+/* A snapshot of the device parameters. Never modified once published:
+ * changelink replaces it as a whole (RCU), so readers see either the old
+ * or the new set, never a mix of both.
+ */
 struct dummy_iface_params {
+	struct rcu_head rcu;
+	u32 version;	/* bumped by every changelink that changes a value */
+
+	/* Values, compared by di_params_equal() from attr0 on */
 	__u8  attr0;
 	__u16 attr1;
 	__u32 attr2;
@@ -23,16 +40,228 @@ struct dummy_iface_params {
 	__u32 attr_nest_b;
 
 	struct ifla_dummy_iface_bin_attr attr_bin;
+
+	__u8  mode;
+
+	/* Impairments, see dummy_iface_impair.c */
+	__u32 drop;
+	__u32 delay;
+	__u32 jitter;
+	__u64 rate;
+	__u32 burst;
+
+	/* Generator, see dummy_iface_gen.c */
+	__u32 gen_rate;
+	__u16 gen_len;
+
+	/* IFLA_DUMMY_IFACE_QUEUE_CPUS, queues past the last one are not
+	 * bound. Variable size, allocated along with the snapshot.
+	 */
+	__u32 nr_queue_cpus;
+	__s32 queue_cpus[];
+};
+
+static inline bool dummy_iface_impaired(const struct dummy_iface_params *p)
+{
+	return p->drop || p->delay || p->jitter || p->rate;
+}
+
+/* A GSO frame counts as the segments a NIC would put on the wire, each
+ * one with its own copy of the headers.
+ */
+static inline unsigned int dummy_iface_skb_segs(const struct sk_buff *skb)
+{
+	return skb_is_gso(skb) ? max_t(u16, skb_shinfo(skb)->gso_segs, 1) : 1;
+}
+
+static inline unsigned int
+dummy_iface_skb_wire_len(const struct sk_buff *skb, unsigned int segs)
+{
+	unsigned int hdr_len;
+
+	if (segs == 1 ||
+	    !(skb_shinfo(skb)->gso_type & (SKB_GSO_TCPV4 | SKB_GSO_TCPV6)))
+		return skb->len;
+
+	if (skb->encapsulation)
+		hdr_len = skb_inner_transport_offset(skb) +
+			  inner_tcp_hdrlen(skb);
+	else
+		hdr_len = skb_transport_offset(skb) + tcp_hdrlen(skb);
+
+	return skb->len + (segs - 1) * hdr_len;
+}
+
+/* Per-CPU datapath counters, summed up in ndo_get_stats64 */
+struct dummy_iface_pcpu_stats {
+	u64 tx_packets;
+	u64 tx_bytes;
+	u64 tx_dropped;
+	u64 rx_packets;
+	u64 rx_bytes;
+	u64 rx_dropped;
+	struct u64_stats_sync syncp;
+};
+
+/* XDP frames are copied into a page of their own with room in front for
+ * bpf_xdp_adjust_head() and room behind for the skb_shared_info that
+ * build_skb() needs on XDP_PASS.
+ */
+#define DI_XDP_HEADROOM		256
+#define DI_XDP_MAX_FRAME	(PAGE_SIZE - DI_XDP_HEADROOM - \
+				 SKB_DATA_ALIGN(sizeof(struct skb_shared_info)))
+#define DI_XDP_MAX_MTU		(DI_XDP_MAX_FRAME - VLAN_ETH_HLEN)
+/* Pages a queue keeps for reuse after XDP_DROP/XDP_TX */
+#define DI_XDP_PAGE_CACHE	64
+
+struct bpf_prog;
+struct netdev_xdp;
+
+/* Delayed frames wait on a timer wheel of DI_WHEEL_SLOTS slots of
+ * DI_WHEEL_TICK_NS each, which bounds delay + jitter.
+ */
+#define DI_WHEEL_SLOTS		1024
+#define DI_WHEEL_TICK_NS	(100 * NSEC_PER_USEC)
+#define DI_DELAY_MAX_US		100000
+/* Delayed frames a queue may hold before new ones are dropped */
+#define DI_DELAY_LIMIT		16384
+
+struct dummy_iface_wheel {
+	u64 cursor;		/* next tick to expire */
+	unsigned int pending;	/* frames on the wheel */
+	struct sk_buff_head slot[DI_WHEEL_SLOTS];
 };
 
+/* Frames a loopback queue may hold before new ones are dropped */
+#define DI_RX_QUEUE_LEN		1024
+
+/* Loopback state of a tx queue: frames transmitted on queue N are
+ * received back by the NAPI instance of queue N, on the CPU the queue is
+ * bound to if any (dummy_iface_queue_kick).
+ */
+struct dummy_iface_queue {
+	struct napi_struct napi;
+	struct sk_buff_head rxq;
+
+	/* IFLA_DUMMY_IFACE_QUEUE_CPUS entry, -1 if not bound */
+	int cpu;
+	/* Schedules the NAPI on @cpu, owned by whoever set NAPI_STATE_SCHED */
+	struct call_single_data csd;
+
+	/* Only touched from the NAPI poll of this queue */
+	unsigned int xdp_npages;
+	struct page *xdp_pages[DI_XDP_PAGE_CACHE];
+
+	/* Impairments: rate limiter state, updated with cmpxchg */
+	atomic64_t tat;
+	/* Delayed frames handed over by the xmit path ... */
+	struct sk_buff_head delayq;
+	/* ... and put on the wheel by the NAPI poll, its only user */
+	struct dummy_iface_wheel *wheel;
+	struct hrtimer timer;
+
+	/* Generator, only touched from the NAPI poll of this queue */
+	u64 gen_next;		/* when the next frame is due */
+	u64 gen_interval;
+	bool gen_on;
+	struct hrtimer gen_timer;
+} ____cacheline_aligned_in_smp;
 
 struct dummy_iface {
 	struct net_device *dev;
-	struct dummy_iface_params params;
+	struct dummy_iface_params __rcu *params;
+	struct dummy_iface_pcpu_stats __percpu *stats;
+	struct dummy_iface_queue *queues; /* dev->num_tx_queues entries */
+	struct bpf_prog __rcu *xdp_prog;
+
+	/* Devices created by one RTM_NEWLINK with IFLA_DUMMY_IFACE_COUNT,
+	 * linked to the list of the device the request was issued for
+	 * (batch_leader). Protected by rtnl_lock.
+	 */
+	struct list_head batch;
+	bool batch_leader;
+
+	/* Entry of the registry of the device's namespace, NULL if not in */
+	struct list_head net_list;
+	struct dummy_iface_net *net;
+};
+
+/* DUMMY_IFACE_STATS_*, updated outside of rtnl_lock */
+struct dummy_iface_dump_stats {
+	atomic64_t fill_calls;
+	atomic64_t fill_bytes;
+	atomic64_t dumps;
+	atomic64_t dump_msgs;
+	atomic64_t dump_devs;
+	atomic64_t dump_ns;
 };
 
+/* The dummy_iface devices of a network namespace */
+struct dummy_iface_net {
+	struct list_head devs;	/* RCU, changed under rtnl_lock */
+	unsigned int count;
+	unsigned int seq;	/* bumped on every change, for dumps */
+	struct dummy_iface_dump_stats stats;
+};
+
+#define dummy_iface_for_each_rcu(_di, _dn) \
+	list_for_each_entry_rcu(_di, &(_dn)->devs, net_list)
+
+/* Under rtnl_lock */
+#define dummy_iface_for_each(_di, _dn) \
+	list_for_each_entry(_di, &(_dn)->devs, net_list)
+
 int dummy_iface_netlink_init(void);
 void dummy_iface_netlink_fini(void);
-bool is_dummy_iface(struct net_device *dev);
+bool is_dummy_iface(const struct net_device *dev);
+void dummy_iface_queue_kick(struct dummy_iface_queue *q);
+
+int dummy_iface_genl_init(void);
+void dummy_iface_genl_fini(void);
+
+int dummy_iface_net_init(void);
+void dummy_iface_net_fini(void);
+struct dummy_iface_net *dummy_iface_net(const struct net *net);
+void dummy_iface_net_add(struct dummy_iface *di);
+void dummy_iface_net_del(struct dummy_iface *di);
+
+int dummy_iface_xdp(struct net_device *dev, struct netdev_xdp *xdp);
+struct sk_buff *dummy_iface_xdp_rx(struct dummy_iface *di,
+				   struct dummy_iface_queue *q,
+				   struct bpf_prog *prog,
+				   struct sk_buff *skb);
+void dummy_iface_xdp_queue_purge(struct dummy_iface_queue *q);
+void dummy_iface_xdp_uninit(struct dummy_iface *di);
+
+/* What dummy_iface_impair did with a frame */
+enum dummy_iface_verdict {
+	DUMMY_IFACE_PASS,	/* the caller goes on with it */
+	DUMMY_IFACE_DELAYED,	/* sent later by the NAPI poll of its queue */
+	DUMMY_IFACE_DROPPED,
+};
+
+enum dummy_iface_verdict dummy_iface_impair(struct dummy_iface *di,
+		const struct dummy_iface_params *params,
+		struct sk_buff *skb, unsigned int segs, unsigned int len);
+int dummy_iface_impair_prepare(struct dummy_iface *di,
+			       const struct dummy_iface_params *params);
+int dummy_iface_delay_poll(struct dummy_iface *di,
+			   struct dummy_iface_queue *q,
+			   int budget,
+			   struct sk_buff_head *out);
+u64 dummy_iface_delay_arm(struct dummy_iface_queue *q);
+void dummy_iface_impair_queue_init(struct dummy_iface_queue *q);
+void dummy_iface_impair_queue_purge(struct dummy_iface_queue *q);
+void dummy_iface_impair_queue_uninit(struct dummy_iface_queue *q);
+
+int dummy_iface_gen_poll(struct dummy_iface *di,
+			 struct dummy_iface_queue *q,
+			 const struct dummy_iface_params *params,
+			 int budget,
+			 struct sk_buff_head *out);
+u64 dummy_iface_gen_arm(struct dummy_iface_queue *q);
+void dummy_iface_gen_start(struct dummy_iface *di);
+void dummy_iface_gen_queue_init(struct dummy_iface_queue *q);
+void dummy_iface_gen_queue_purge(struct dummy_iface_queue *q);
 
 #endif /* DUMMY_IFACE_H_ */
@@ -0,0 +1,159 @@
+/*
+ * dummy_iface_gen.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsi
+ */
+
+#define pr_fmt(fmt)	"(dummy iface gen): " fmt
+
+#include <linux/etherdevice.h>
+#include <linux/hrtimer.h>
+#include <linux/if_ether.h>
+#include <linux/ktime.h>
+#include <linux/netdevice.h>
+#include <linux/rtnetlink.h>
+#include <linux/skbuff.h>
+
+#include "dummy_iface.h"
+
+/*
+ * Receive side traffic generator (IFLA_DUMMY_IFACE_GEN_RATE), pktgen only
+ * drives transmission. The NAPI poll of every queue synthesizes frames at
+ * GEN_RATE frames per second and hands them to the stack as received
+ * ones, on the CPU the queue is bound to (IFLA_DUMMY_IFACE_QUEUE_CPUS).
+ *
+ * A frame is GEN_LEN bytes: an Ethernet header addressed to the device,
+ * ethertype ETH_P_802_EX1, attr_bin (IFLA_DUMMY_IFACE_ATTR_BIN) as the
+ * payload and zero padding. Frames come from the NAPI page fragment cache
+ * (napi_alloc_skb) and the timer lets them pile up to DI_GEN_BATCH before
+ * waking the poll, which fills them in one go.
+ */
+
+/* Frames made up for at most when the generator fell behind */
+#define DI_GEN_BACKLOG		NAPI_POLL_WEIGHT
+/* Frames per wakeup, as long as the first one waits at most ... */
+#define DI_GEN_BATCH		16
+/* ... this long */
+#define DI_GEN_MAX_WAIT_NS	(50 * NSEC_PER_USEC)
+
+static struct sk_buff *di_gen_frame(struct dummy_iface *di,
+				    struct dummy_iface_queue *q,
+				    const struct dummy_iface_params *params,
+				    unsigned int len)
+{
+	const unsigned int payload = sizeof(params->attr_bin);
+	struct sk_buff *skb;
+	struct ethhdr *eth;
+
+	skb = napi_alloc_skb(&q->napi, len);
+	if (unlikely(!skb))
+		return NULL;
+
+	eth = (struct ethhdr *)skb_put(skb, len);
+	ether_addr_copy(eth->h_dest, di->dev->dev_addr);
+	ether_addr_copy(eth->h_source, di->dev->dev_addr);
+	eth->h_proto = htons(ETH_P_802_EX1);
+	memcpy(eth + 1, &params->attr_bin, payload);
+	memset((u8 *)(eth + 1) + payload, 0, len - ETH_HLEN - payload);
+
+	return skb;
+}
+
+/* Called from the NAPI poll of @q under rcu_read_lock(). Puts the frames
+ * due by now, at most @budget of them, on @out and returns how many.
+ */
+int dummy_iface_gen_poll(struct dummy_iface *di,
+			 struct dummy_iface_queue *q,
+			 const struct dummy_iface_params *params,
+			 int budget,
+			 struct sk_buff_head *out)
+{
+	unsigned int len = params->gen_len ? : ETH_ZLEN;
+	struct sk_buff *skb;
+	int n = 0;
+	u64 now;
+
+	q->gen_on = params->gen_rate != 0;
+	if (!q->gen_on)
+		return 0;
+
+	now = ktime_get_ns();
+	q->gen_interval = NSEC_PER_SEC / params->gen_rate;
+
+	/* Started, or starved: do not burst to catch up */
+	if (q->gen_next + DI_GEN_BACKLOG * q->gen_interval < now)
+		q->gen_next = now;
+
+	while (n < budget && q->gen_next <= now) {
+		skb = di_gen_frame(di, q, params, len);
+		if (unlikely(!skb))
+			break;
+
+		__skb_queue_tail(out, skb);
+		q->gen_next += q->gen_interval;
+		n++;
+	}
+
+	return n;
+}
+
+/* Called before napi_complete(): wake the poll up for the next batch.
+ * Returns when, 0 if the generator is off.
+ */
+u64 dummy_iface_gen_arm(struct dummy_iface_queue *q)
+{
+	u64 expires;
+
+	if (!q->gen_on)
+		return 0;
+
+	expires = q->gen_next + min_t(u64, (DI_GEN_BATCH - 1) * q->gen_interval,
+				      DI_GEN_MAX_WAIT_NS);
+	hrtimer_start(&q->gen_timer, ns_to_ktime(expires), HRTIMER_MODE_ABS);
+
+	return expires;
+}
+
+static enum hrtimer_restart di_gen_timer(struct hrtimer *timer)
+{
+	struct dummy_iface_queue *q = container_of(timer,
+						   struct dummy_iface_queue,
+						   gen_timer);
+
+	dummy_iface_queue_kick(q);
+
+	return HRTIMER_NORESTART;
+}
+
+/* Under rtnl_lock, with the device up: the polls keep the generator
+ * going from the first one on.
+ */
+void dummy_iface_gen_start(struct dummy_iface *di)
+{
+	unsigned int i;
+
+	if (!rtnl_dereference(di->params)->gen_rate)
+		return;
+
+	/* The NET_RX softirq runs when BH is enabled again */
+	local_bh_disable();
+	for (i = 0; i < di->dev->num_tx_queues; i++)
+		dummy_iface_queue_kick(&di->queues[i]);
+	local_bh_enable();
+}
+
+void dummy_iface_gen_queue_init(struct dummy_iface_queue *q)
+{
+	q->gen_on = false;
+	q->gen_next = 0;
+	hrtimer_init(&q->gen_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+	q->gen_timer.function = di_gen_timer;
+}
+
+/* Called with the NAPI instance of @q disabled */
+void dummy_iface_gen_queue_purge(struct dummy_iface_queue *q)
+{
+	hrtimer_cancel(&q->gen_timer);
+	q->gen_on = false;
+}
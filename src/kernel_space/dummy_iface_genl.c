@@ -0,0 +1,341 @@
+/*
+ * dummy_iface_genl.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsi
+ */
+
+#define pr_fmt(fmt)	"(dummy iface genl): " fmt
+
+#include <linux/ktime.h>
+#include <linux/netdevice.h>
+#include <linux/rculist.h>
+#include <linux/rtnetlink.h>
+#include <net/genetlink.h>
+#include <net/netlink.h>
+
+#include "dummy_iface.h"
+#include "dummy_iface_macro.h"
+
+/*
+ * The "dummy_iface" generic netlink family. A netdevice notifier turns
+ * the changes of dummy_iface devices into compact events on the "events"
+ * group: ifindex, name, flags, mtu, address and the driver attributes,
+ * the same ones rtnl_link_ops->fill_info() puts in IFLA_INFO_DATA.
+ * DUMMY_IFACE_CMD_GETLINK dumps the devices in the same format, for
+ * listeners that (re)start from the current state. It walks the module's
+ * own registry, so it costs the dummy_iface devices only, however many
+ * other links the namespace has.
+ * DUMMY_IFACE_CMD_GETSTATS reports what the serialization costs.
+ */
+
+static int di_genl_dump_start(struct netlink_callback *cb);
+static int di_genl_dump(struct sk_buff *skb, struct netlink_callback *cb);
+static int di_genl_getstats(struct sk_buff *skb, struct genl_info *info);
+
+static const struct genl_ops di_genl_ops[] = {
+	{
+		.cmd	= DUMMY_IFACE_CMD_GETLINK,
+		.start	= di_genl_dump_start,
+		.dumpit	= di_genl_dump,
+	},
+	{
+		.cmd	= DUMMY_IFACE_CMD_GETSTATS,
+		.doit	= di_genl_getstats,
+	},
+};
+
+static const struct genl_multicast_group di_genl_mcgrps[] = {
+	{ .name = DUMMY_IFACE_GENL_MCGRP },
+};
+
+static struct genl_family di_genl_family __ro_after_init = {
+	.name		= DUMMY_IFACE_GENL_NAME,
+	.version	= DUMMY_IFACE_GENL_VERSION,
+	.maxattr	= DUMMY_IFACE_A_MAX,
+	.netnsok	= true,
+	.module		= THIS_MODULE,
+	.ops		= di_genl_ops,
+	.n_ops		= ARRAY_SIZE(di_genl_ops),
+	.mcgrps		= di_genl_mcgrps,
+	.n_mcgrps	= ARRAY_SIZE(di_genl_mcgrps),
+};
+
+static size_t di_genl_msg_size(const struct net_device *dev)
+{
+	return nla_total_size(sizeof(u32)) + /* DUMMY_IFACE_A_IFINDEX */
+		nla_total_size(IFNAMSIZ) + /* DUMMY_IFACE_A_IFNAME */
+		nla_total_size(sizeof(u32)) + /* DUMMY_IFACE_A_FLAGS */
+		nla_total_size(sizeof(u32)) + /* DUMMY_IFACE_A_MTU */
+		nla_total_size(MAX_ADDR_LEN) + /* DUMMY_IFACE_A_ADDRESS */
+		nla_total_size(0) + /* DUMMY_IFACE_A_DATA */
+		dev->rtnl_link_ops->get_size(dev);
+}
+
+static int di_genl_fill(struct sk_buff *skb, const struct net_device *dev,
+			u8 cmd, u32 portid, u32 seq, int flags)
+{
+	struct nlattr *data;
+	void *hdr;
+
+	hdr = genlmsg_put(skb, portid, seq, &di_genl_family, flags, cmd);
+	if (!hdr)
+		return -EMSGSIZE;
+
+	if (nla_put_u32(skb, DUMMY_IFACE_A_IFINDEX, dev->ifindex) ||
+	    nla_put_string(skb, DUMMY_IFACE_A_IFNAME, dev->name) ||
+	    nla_put_u32(skb, DUMMY_IFACE_A_FLAGS, dev_get_flags(dev)) ||
+	    nla_put_u32(skb, DUMMY_IFACE_A_MTU, dev->mtu) ||
+	    nla_put(skb, DUMMY_IFACE_A_ADDRESS, dev->addr_len, dev->dev_addr))
+		goto nla_put_failure;
+
+	if (cmd != DUMMY_IFACE_CMD_DELLINK) {
+		data = nla_nest_start(skb, DUMMY_IFACE_A_DATA);
+		if (!data)
+			goto nla_put_failure;
+		if (dev->rtnl_link_ops->fill_info(skb, dev))
+			goto nla_put_failure;
+		nla_nest_end(skb, data);
+	}
+
+	genlmsg_end(skb, hdr);
+
+	return 0;
+
+nla_put_failure:
+	genlmsg_cancel(skb, hdr);
+	return -EMSGSIZE;
+}
+
+static void di_genl_notify(struct net_device *dev, u8 cmd)
+{
+	struct net *net = dev_net(dev);
+	struct sk_buff *skb;
+	int err;
+
+	/* Nobody listens in this namespace, the common case */
+	if (!genl_has_listeners(&di_genl_family, net, 0))
+		return;
+
+	skb = genlmsg_new(di_genl_msg_size(dev), GFP_KERNEL);
+	if (!skb) {
+		err = -ENOBUFS;
+		goto err;
+	}
+
+	err = di_genl_fill(skb, dev, cmd, 0, 0, 0);
+	if (err) {
+		/* di_genl_msg_size() is wrong */
+		WARN_ON(err == -EMSGSIZE);
+		kfree_skb(skb);
+		goto err;
+	}
+
+	genlmsg_multicast_netns(&di_genl_family, net, skb, 0, 0, GFP_KERNEL);
+	return;
+
+err:
+	/* Listeners see an overrun and resync */
+	netlink_set_err(net->genl_sock, 0,
+			di_genl_family.mcgrp_offset, err);
+}
+
+/* Where the previous part of a dump stopped, in cb->args */
+enum {
+	DI_DUMP_IFINDEX,	/* last device put */
+	DI_DUMP_IDX,		/* devices put so far */
+};
+
+static int di_genl_dump_start(struct netlink_callback *cb)
+{
+	struct dummy_iface_net *dn = dummy_iface_net(sock_net(cb->skb->sk));
+
+	atomic64_inc(&dn->stats.dumps);
+
+	return 0;
+}
+
+/* The registry entry to continue after: the last device put, found by
+ * its ifindex instead of walking past every device put so far again.
+ * When it went away meanwhile, fall back to its position; the dump is
+ * flagged NLM_F_DUMP_INTR in that case anyway. NULL when nothing is left.
+ */
+static struct list_head *di_genl_dump_pos(struct net *net,
+					  struct dummy_iface_net *dn,
+					  struct netlink_callback *cb)
+{
+	struct list_head *pos = &dn->devs;
+	struct net_device *dev;
+	long idx;
+
+	if (!cb->args[DI_DUMP_IDX])
+		return pos;
+
+	dev = dev_get_by_index_rcu(net, cb->args[DI_DUMP_IFINDEX]);
+	if (dev && is_dummy_iface(dev)) {
+		struct dummy_iface *di = netdev_priv(dev);
+
+		if (READ_ONCE(di->net) == dn)
+			return &di->net_list;
+	}
+
+	for (idx = cb->args[DI_DUMP_IDX]; idx > 0; idx--) {
+		pos = rcu_dereference(list_next_rcu(pos));
+		if (pos == &dn->devs)
+			return NULL;
+	}
+
+	return pos;
+}
+
+static int di_genl_dump(struct sk_buff *skb, struct netlink_callback *cb)
+{
+	struct net *net = sock_net(skb->sk);
+	struct dummy_iface_net *dn = dummy_iface_net(net);
+	struct dummy_iface *di;
+	struct list_head *pos;
+	u64 start = ktime_get_ns();
+	int n = 0;
+
+	rcu_read_lock();
+	cb->seq = dn->seq;
+
+	pos = di_genl_dump_pos(net, dn, cb);
+	if (!pos)
+		goto out;
+
+	di = list_entry(pos, struct dummy_iface, net_list);
+	list_for_each_entry_continue_rcu(di, &dn->devs, net_list) {
+		if (di_genl_fill(skb, di->dev, DUMMY_IFACE_CMD_NEWLINK,
+				 NETLINK_CB(cb->skb).portid,
+				 cb->nlh->nlmsg_seq, NLM_F_MULTI))
+			break;
+		nl_dump_check_consistent(cb, nlmsg_hdr(skb));
+
+		cb->args[DI_DUMP_IFINDEX] = di->dev->ifindex;
+		cb->args[DI_DUMP_IDX]++;
+		n++;
+	}
+
+out:
+	rcu_read_unlock();
+
+	atomic64_inc(&dn->stats.dump_msgs);
+	atomic64_add(n, &dn->stats.dump_devs);
+	atomic64_add(ktime_get_ns() - start, &dn->stats.dump_ns);
+
+	return skb->len;
+}
+
+static int di_genl_put_stat(struct sk_buff *skb, int type, atomic64_t *v)
+{
+	return nla_put_u64_64bit(skb, type, atomic64_read(v),
+				 DUMMY_IFACE_STATS_PAD);
+}
+
+static int di_genl_getstats(struct sk_buff *skb, struct genl_info *info)
+{
+	struct dummy_iface_net *dn = dummy_iface_net(genl_info_net(info));
+	struct dummy_iface_dump_stats *stats = &dn->stats;
+	struct nlattr *nest;
+	struct sk_buff *msg;
+	void *hdr;
+
+	msg = genlmsg_new(NLMSG_GOODSIZE, GFP_KERNEL);
+	if (!msg)
+		return -ENOMEM;
+
+	hdr = genlmsg_put_reply(msg, info, &di_genl_family, 0,
+				DUMMY_IFACE_CMD_GETSTATS);
+	if (!hdr)
+		goto nla_put_failure;
+
+	nest = nla_nest_start(msg, DUMMY_IFACE_A_STATS);
+	if (!nest)
+		goto nla_put_failure;
+
+	if (nla_put_u32(msg, DUMMY_IFACE_STATS_DEVICES, READ_ONCE(dn->count)) ||
+	    di_genl_put_stat(msg, DUMMY_IFACE_STATS_FILL_CALLS,
+			     &stats->fill_calls) ||
+	    di_genl_put_stat(msg, DUMMY_IFACE_STATS_FILL_BYTES,
+			     &stats->fill_bytes) ||
+	    di_genl_put_stat(msg, DUMMY_IFACE_STATS_DUMPS, &stats->dumps) ||
+	    di_genl_put_stat(msg, DUMMY_IFACE_STATS_DUMP_MSGS,
+			     &stats->dump_msgs) ||
+	    di_genl_put_stat(msg, DUMMY_IFACE_STATS_DUMP_DEVS,
+			     &stats->dump_devs) ||
+	    di_genl_put_stat(msg, DUMMY_IFACE_STATS_DUMP_NS, &stats->dump_ns))
+		goto nla_put_failure;
+
+	nla_nest_end(msg, nest);
+	genlmsg_end(msg, hdr);
+
+	return genlmsg_reply(msg, info);
+
+nla_put_failure:
+	nlmsg_free(msg);
+	return -EMSGSIZE;
+}
+
+static int di_genl_netdev_event(struct notifier_block *nb,
+				unsigned long event, void *ptr)
+{
+	struct net_device *dev = netdev_notifier_info_to_dev(ptr);
+	u8 cmd;
+
+	if (!is_dummy_iface(dev))
+		return NOTIFY_DONE;
+
+	switch (event) {
+	case NETDEV_REGISTER:
+		cmd = DUMMY_IFACE_CMD_NEWLINK;
+		break;
+	case NETDEV_UNREGISTER:
+		cmd = DUMMY_IFACE_CMD_DELLINK;
+		break;
+	case NETDEV_UP:
+	case NETDEV_DOWN:
+	case NETDEV_CHANGE:
+	case NETDEV_CHANGEMTU:
+	case NETDEV_CHANGEADDR:
+	case NETDEV_CHANGENAME:
+	case NETDEV_CHANGEINFODATA:
+		cmd = DUMMY_IFACE_CMD_CHANGELINK;
+		break;
+	default:
+		return NOTIFY_DONE;
+	}
+
+	di_genl_notify(dev, cmd);
+
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block di_genl_notifier = {
+	.notifier_call = di_genl_netdev_event,
+};
+
+int dummy_iface_genl_init(void)
+{
+	int err;
+
+	DI_TRACE_CALL(err);
+
+	err = genl_register_family(&di_genl_family);
+	if (err)
+		return err;
+
+	err = register_netdevice_notifier(&di_genl_notifier);
+	if (err)
+		genl_unregister_family(&di_genl_family);
+
+	return err;
+}
+
+void dummy_iface_genl_fini(void)
+{
+	DI_TRACE_CALL(err);
+
+	unregister_netdevice_notifier(&di_genl_notifier);
+	genl_unregister_family(&di_genl_family);
+}
@@ -0,0 +1,323 @@
+/*
+ * dummy_iface_impair.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsi
+ */
+
+#define pr_fmt(fmt)	"(dummy iface impair): " fmt
+
+#include <linux/atomic.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/netdevice.h>
+#include <linux/random.h>
+#include <linux/skbuff.h>
+#include <linux/vmalloc.h>
+
+#include "dummy_iface.h"
+
+/*
+ * netem-like impairments applied by the xmit path, without a qdisc and
+ * without locks shared between transmitting CPUs:
+ *
+ * drop:	IFLA_DUMMY_IFACE_DROP, stateless, one prandom_u32() per frame.
+ *		U32_MAX drops every frame, the draw alone would let 1 in
+ *		2^32 through.
+ *
+ * rate:	IFLA_DUMMY_IFACE_RATE/BURST, a policer per tx queue, so the
+ *		device as a whole passes up to num_tx_queues times the
+ *		rate. Sharing one tat would put every transmitting CPU on
+ *		the same cache line. It is
+ *		run as a GCRA (virtual scheduling): the queue keeps the
+ *		theoretical arrival time (tat) of the next frame and a frame
+ *		conforms if it does not arrive more than BURST bytes worth
+ *		of time before it. The tat is advanced with a cmpxchg.
+ *
+ * delay:	IFLA_DUMMY_IFACE_DELAY/JITTER. The xmit path stamps the frame
+ *		with its release tick and hands it over to the queue; the
+ *		NAPI poll of the queue sorts it into a timer wheel that only
+ *		the poll touches, releases expired slots and arms an hrtimer
+ *		to be scheduled again for the next busy slot.
+ *
+ * What happens to a frame that made it through depends on the mode: it
+ * is freed (sink) or received back (loopback).
+ */
+
+struct dummy_iface_skb_cb {
+	u64 tick;	/* release time, in DI_WHEEL_TICK_NS */
+};
+
+#define DI_SKB_CB(skb)	((struct dummy_iface_skb_cb *)(skb)->cb)
+
+static void di_impair_drop(struct dummy_iface *di, struct sk_buff *skb,
+			   unsigned int segs)
+{
+	struct dummy_iface_pcpu_stats *stats = this_cpu_ptr(di->stats);
+
+	u64_stats_update_begin(&stats->syncp);
+	stats->tx_dropped += segs;
+	u64_stats_update_end(&stats->syncp);
+
+	kfree_skb(skb);
+}
+
+static bool di_rate_conform(struct dummy_iface_queue *q,
+			    const struct dummy_iface_params *params,
+			    unsigned int len)
+{
+	s64 now = ktime_get_ns();
+	s64 cost = div64_u64((u64)len * NSEC_PER_SEC, params->rate);
+	s64 tolerance = div64_u64((u64)params->burst * NSEC_PER_SEC,
+				  params->rate);
+	s64 old, tat;
+
+	do {
+		old = atomic64_read(&q->tat);
+		tat = max(old, now);
+		if (tat - now > tolerance)
+			return false;
+	} while (atomic64_cmpxchg(&q->tat, old, tat + cost) != old);
+
+	return true;
+}
+
+static u64 di_release_tick(const struct dummy_iface_params *params)
+{
+	s64 delay = (s64)params->delay * NSEC_PER_USEC;
+
+	if (params->jitter)
+		delay += ((s64)prandom_u32_max(2 * params->jitter + 1) -
+			  params->jitter) * NSEC_PER_USEC;
+
+	return div_u64(ktime_get_ns() + max_t(s64, delay, 0),
+		       DI_WHEEL_TICK_NS);
+}
+
+/* Called from ndo_start_xmit with the @segs and wire @len of @skb, which
+ * the caller no longer owns unless DUMMY_IFACE_PASS is returned.
+ */
+enum dummy_iface_verdict dummy_iface_impair(struct dummy_iface *di,
+		const struct dummy_iface_params *params,
+		struct sk_buff *skb, unsigned int segs, unsigned int len)
+{
+	struct dummy_iface_queue *q = &di->queues[skb_get_queue_mapping(skb)];
+
+	if (params->drop &&
+	    (params->drop == U32_MAX || prandom_u32() < params->drop))
+		goto drop;
+
+	/* A GSO frame pays for every segment it stands for */
+	if (params->rate && !di_rate_conform(q, params, len))
+		goto drop;
+
+	if (!(params->delay || params->jitter) || unlikely(!q->wheel))
+		return DUMMY_IFACE_PASS;
+
+	if (unlikely(skb_queue_len(&q->delayq) >= DI_DELAY_LIMIT))
+		goto drop;
+
+	/* Do not keep the sender's socket (and its wmem) hostage */
+	skb_orphan(skb);
+	skb_scrub_packet(skb, false);
+
+	DI_SKB_CB(skb)->tick = di_release_tick(params);
+	skb_queue_tail(&q->delayq, skb);
+	dummy_iface_queue_kick(q);
+
+	return DUMMY_IFACE_DELAYED;
+
+drop:
+	di_impair_drop(di, skb, segs);
+	return DUMMY_IFACE_DROPPED;
+}
+
+/* Give every queue a wheel before @params with a delay are published.
+ * Called under rtnl_lock from ndo_init and changelink; a wheel is kept
+ * until the device goes away.
+ */
+int dummy_iface_impair_prepare(struct dummy_iface *di,
+			       const struct dummy_iface_params *params)
+{
+	unsigned int i, j;
+
+	if (!di->queues || !(params->delay || params->jitter))
+		return 0;
+
+	for (i = 0; i < di->dev->num_tx_queues; i++) {
+		struct dummy_iface_queue *q = &di->queues[i];
+		struct dummy_iface_wheel *w;
+
+		if (q->wheel)
+			continue;
+
+		w = vzalloc(sizeof(*w));
+		if (!w)
+			return -ENOMEM;
+
+		for (j = 0; j < DI_WHEEL_SLOTS; j++)
+			__skb_queue_head_init(&w->slot[j]);
+
+		/* Pairs with smp_load_acquire() in dummy_iface_delay_poll */
+		smp_store_release(&q->wheel, w);
+	}
+
+	return 0;
+}
+
+static void di_wheel_insert(struct dummy_iface_wheel *w, struct sk_buff *skb)
+{
+	u64 tick = max(DI_SKB_CB(skb)->tick, w->cursor);
+
+	DI_SKB_CB(skb)->tick = tick;
+	__skb_queue_tail(&w->slot[tick & (DI_WHEEL_SLOTS - 1)], skb);
+	w->pending++;
+}
+
+/* Move the frames due at @now into @out, at most @budget of them. A slot
+ * may also hold frames of a later turn of the wheel, those stay.
+ */
+static int di_wheel_expire(struct dummy_iface_wheel *w, u64 now,
+			   int budget, struct sk_buff_head *out)
+{
+	int done = 0;
+
+	while (w->pending && w->cursor <= now) {
+		struct sk_buff_head *slot;
+		struct sk_buff *skb, *tmp;
+
+		slot = &w->slot[w->cursor & (DI_WHEEL_SLOTS - 1)];
+		skb_queue_walk_safe(slot, skb, tmp) {
+			if (DI_SKB_CB(skb)->tick > w->cursor)
+				continue;
+			if (done == budget)
+				return done;
+
+			__skb_unlink(skb, slot);
+			__skb_queue_tail(out, skb);
+			w->pending--;
+			done++;
+		}
+
+		w->cursor++;
+	}
+
+	return done;
+}
+
+/* Called from the NAPI poll of @q: put newly delayed frames on the wheel
+ * and move the expired ones into @out. Returns the number moved.
+ */
+int dummy_iface_delay_poll(struct dummy_iface *di,
+			   struct dummy_iface_queue *q,
+			   int budget,
+			   struct sk_buff_head *out)
+{
+	struct dummy_iface_wheel *w = smp_load_acquire(&q->wheel);
+	struct sk_buff_head inbox;
+	struct sk_buff *skb;
+	unsigned int dropped = 0;
+	u64 now;
+
+	if (!w)
+		return 0;
+
+	__skb_queue_head_init(&inbox);
+	if (!skb_queue_empty(&q->delayq)) {
+		spin_lock(&q->delayq.lock);
+		skb_queue_splice_init(&q->delayq, &inbox);
+		spin_unlock(&q->delayq.lock);
+	}
+
+	now = div_u64(ktime_get_ns(), DI_WHEEL_TICK_NS);
+	if (!w->pending)
+		w->cursor = now;
+
+	while ((skb = __skb_dequeue(&inbox)) != NULL) {
+		if (unlikely(w->pending >= DI_DELAY_LIMIT)) {
+			dropped += dummy_iface_skb_segs(skb);
+			kfree_skb(skb);
+			continue;
+		}
+		di_wheel_insert(w, skb);
+	}
+
+	if (unlikely(dropped)) {
+		struct dummy_iface_pcpu_stats *stats = this_cpu_ptr(di->stats);
+
+		u64_stats_update_begin(&stats->syncp);
+		stats->tx_dropped += dropped;
+		u64_stats_update_end(&stats->syncp);
+	}
+
+	return di_wheel_expire(w, now, budget, out);
+}
+
+/* Called from the NAPI poll of @q before it completes: arm the timer for
+ * the first busy slot. Returns its expiry (ns) or 0 if the wheel is idle.
+ */
+u64 dummy_iface_delay_arm(struct dummy_iface_queue *q)
+{
+	struct dummy_iface_wheel *w = q->wheel;
+	unsigned int i;
+	u64 expires;
+
+	if (!w || !w->pending)
+		return 0;
+
+	for (i = 0; i < DI_WHEEL_SLOTS; i++)
+		if (!skb_queue_empty(&w->slot[(w->cursor + i) &
+					      (DI_WHEEL_SLOTS - 1)]))
+			break;
+
+	expires = (w->cursor + i) * DI_WHEEL_TICK_NS;
+	hrtimer_start(&q->timer, ns_to_ktime(expires), HRTIMER_MODE_ABS);
+
+	return expires;
+}
+
+static enum hrtimer_restart di_delay_timer(struct hrtimer *timer)
+{
+	struct dummy_iface_queue *q = container_of(timer,
+						   struct dummy_iface_queue,
+						   timer);
+
+	dummy_iface_queue_kick(q);
+
+	return HRTIMER_NORESTART;
+}
+
+void dummy_iface_impair_queue_init(struct dummy_iface_queue *q)
+{
+	BUILD_BUG_ON(sizeof(struct dummy_iface_skb_cb) >
+		     FIELD_SIZEOF(struct sk_buff, cb));
+
+	atomic64_set(&q->tat, 0);
+	skb_queue_head_init(&q->delayq);
+	hrtimer_init(&q->timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+	q->timer.function = di_delay_timer;
+}
+
+/* Called with the NAPI instance of @q disabled */
+void dummy_iface_impair_queue_purge(struct dummy_iface_queue *q)
+{
+	unsigned int i;
+
+	hrtimer_cancel(&q->timer);
+	skb_queue_purge(&q->delayq);
+
+	if (!q->wheel)
+		return;
+
+	for (i = 0; i < DI_WHEEL_SLOTS; i++)
+		__skb_queue_purge(&q->wheel->slot[i]);
+	q->wheel->pending = 0;
+}
+
+void dummy_iface_impair_queue_uninit(struct dummy_iface_queue *q)
+{
+	dummy_iface_impair_queue_purge(q);
+	vfree(q->wheel);
+	q->wheel = NULL;
+}
@@ -0,0 +1,193 @@
+/*
+ * dummy_iface_net.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsi
+ */
+
+#define pr_fmt(fmt)	"(dummy iface net): " fmt
+
+#include <linux/netdevice.h>
+#include <linux/rculist.h>
+#include <linux/rtnetlink.h>
+#include <net/net_namespace.h>
+#include <net/netns/generic.h>
+
+#include "dummy_iface.h"
+#include "dummy_iface_macro.h"
+
+/*
+ * Per network namespace registry of the dummy_iface devices, so that the
+ * module walks its own devices instead of every net_device of the
+ * namespace. Changed under rtnl_lock, read under RCU or rtnl_lock.
+ * It also lets a dying namespace take its devices down in one go.
+ */
+
+static unsigned int di_net_id __read_mostly;
+
+struct dummy_iface_net *dummy_iface_net(const struct net *net)
+{
+	return net_generic(net, di_net_id);
+}
+
+/* Called under rtnl_lock once @di is set up (ndo_init) */
+void dummy_iface_net_add(struct dummy_iface *di)
+{
+	struct dummy_iface_net *dn = dummy_iface_net(dev_net(di->dev));
+
+	ASSERT_RTNL();
+
+	list_add_tail_rcu(&di->net_list, &dn->devs);
+	dn->count++;
+	dn->seq++;
+	WRITE_ONCE(di->net, dn);
+}
+
+/* Called under rtnl_lock (ndo_uninit). Readers may still see @di until
+ * the grace period that unregistration waits for before freeing it.
+ */
+void dummy_iface_net_del(struct dummy_iface *di)
+{
+	struct dummy_iface_net *dn = di->net;
+
+	ASSERT_RTNL();
+
+	if (!dn)
+		return;
+
+	list_del_rcu(&di->net_list);
+	dn->count--;
+	dn->seq++;
+	WRITE_ONCE(di->net, NULL);
+}
+
+/* A batch is torn down by its leader (di_dellink), which must not reach
+ * into another namespace: a device changing namespace leaves its batch,
+ * a leader dissolves it.
+ */
+static void di_net_batch_leave(struct dummy_iface *di)
+{
+	struct dummy_iface *peer_di, *tmp;
+
+	if (di->batch_leader) {
+		list_for_each_entry_safe(peer_di, tmp, &di->batch, batch)
+			list_del_init(&peer_di->batch);
+		di->batch_leader = false;
+	} else {
+		list_del_init(&di->batch);
+	}
+}
+
+/* dev_change_net_namespace() does not go through ndo_uninit/ndo_init,
+ * follow the device with the UNREGISTER/REGISTER pair it sends instead.
+ */
+static int di_net_netdev_event(struct notifier_block *nb,
+			       unsigned long event, void *ptr)
+{
+	struct net_device *dev = netdev_notifier_info_to_dev(ptr);
+	struct dummy_iface *di;
+
+	if (!is_dummy_iface(dev))
+		return NOTIFY_DONE;
+
+	di = netdev_priv(dev);
+
+	switch (event) {
+	case NETDEV_UNREGISTER:
+		/* Leaving the namespace, not going away. Readers of the old
+		 * list must be done with the entry before it is linked into
+		 * the new one.
+		 */
+		if (dev->reg_state == NETREG_REGISTERED) {
+			dummy_iface_net_del(di);
+			di_net_batch_leave(di);
+			synchronize_net();
+		}
+		break;
+	case NETDEV_REGISTER:
+		if (!di->net)
+			dummy_iface_net_add(di);
+		break;
+	}
+
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block di_net_notifier = {
+	.notifier_call = di_net_netdev_event,
+};
+
+static int __net_init di_net_init(struct net *net)
+{
+	struct dummy_iface_net *dn = dummy_iface_net(net);
+
+	INIT_LIST_HEAD(&dn->devs);
+	dn->count = 0;
+	dn->seq = 0;
+	memset(&dn->stats, 0, sizeof(dn->stats));
+
+	return 0;
+}
+
+/* Namespaces going away: every device of every one of them is taken
+ * down by a single unregister_netdevice_many(), under one rtnl_lock and
+ * one round of grace periods, instead of one ->dellink per device from
+ * default_device_exit_batch(). Being registered after it, this runs first.
+ */
+static void __net_exit di_net_exit_batch(struct list_head *net_list)
+{
+	struct dummy_iface_net *dn;
+	struct dummy_iface *di;
+	struct net *net;
+	LIST_HEAD(list_kill);
+
+	rtnl_lock();
+
+	list_for_each_entry(net, net_list, exit_list) {
+		dn = dummy_iface_net(net);
+		dummy_iface_for_each(di, dn)
+			unregister_netdevice_queue(di->dev, &list_kill);
+	}
+
+	unregister_netdevice_many(&list_kill);
+
+	list_for_each_entry(net, net_list, exit_list)
+		WARN_ON(!list_empty(&dummy_iface_net(net)->devs));
+
+	rtnl_unlock();
+}
+
+static struct pernet_operations di_net_ops = {
+	.init		= di_net_init,
+	.exit_batch	= di_net_exit_batch,
+	.id		= &di_net_id,
+	.size		= sizeof(struct dummy_iface_net),
+};
+
+int dummy_iface_net_init(void)
+{
+	int err;
+
+	DI_TRACE_CALL(err);
+
+	/* A device, not a subsystem: the devices are gone by the time
+	 * the namespace's subsystems exit.
+	 */
+	err = register_pernet_device(&di_net_ops);
+	if (err)
+		return err;
+
+	err = register_netdevice_notifier(&di_net_notifier);
+	if (err)
+		unregister_pernet_device(&di_net_ops);
+
+	return err;
+}
+
+void dummy_iface_net_fini(void)
+{
+	DI_TRACE_CALL(err);
+
+	unregister_netdevice_notifier(&di_net_notifier);
+	unregister_pernet_device(&di_net_ops);
+}
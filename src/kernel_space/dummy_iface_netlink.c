@@ -13,6 +13,7 @@
 #include <linux/etherdevice.h>
 #include <linux/if_link.h>
 #include <linux/if_ether.h>
+#include <linux/slab.h>
 #include <linux/types.h>
 #include <net/netlink.h>
 #include <net/rtnetlink.h>
@@ -27,49 +28,114 @@ static int di_newlink(struct net *src_net,
 			struct net_device *dev,
 			struct nlattr *tb[],
 			struct nlattr *data[]);
+static int di_newlink_batch(struct net_device *dev,
+			    struct nlattr *tb[],
+			    struct nlattr *data[],
+			    u32 count);
 static int di_changelink(struct net_device *dev,
 			   struct nlattr *tb[],
 			   struct nlattr *data[]);
+static int di_changelink_op(struct net_device *dev,
+			    struct nlattr *tb[],
+			    struct nlattr *data[]);
 static void di_dellink(struct net_device *dev,
 			 struct list_head *head);
 static size_t di_get_size(const struct net_device *dev);
 static int di_fill_info(struct sk_buff *skb,
 			  const struct net_device *dev);
+static unsigned int di_get_num_tx_queues(void);
+static unsigned int di_get_num_rx_queues(void);
 static int di_dev_init(struct net_device *dev);
 static void di_dev_uninit(struct net_device *dev);
-
-static int di_set_nest_opt(struct dummy_iface *di,
-			   int nest_type,
-			   struct nlattr *data[]);
-static int di_set_opt(struct dummy_iface *di, struct nlattr *data[],
+static int di_dev_open(struct net_device *dev);
+static int di_dev_stop(struct net_device *dev);
+static int di_change_mtu(struct net_device *dev, int new_mtu);
+static netdev_features_t di_fix_features(struct net_device *dev,
+					 netdev_features_t features);
+static int di_set_features(struct net_device *dev,
+			   netdev_features_t features);
+static netdev_tx_t di_xmit(struct sk_buff *skb, struct net_device *dev);
+static u16 di_select_queue(struct net_device *dev, struct sk_buff *skb,
+			   void *accel_priv, select_queue_fallback_t fallback);
+static struct rtnl_link_stats64 *di_get_stats64(struct net_device *dev,
+						struct rtnl_link_stats64 *stats);
+static void di_loopback(struct dummy_iface *di, struct sk_buff *skb);
+static void di_receive(struct dummy_iface *di, struct dummy_iface_queue *q,
+		       struct bpf_prog *xdp_prog, struct sk_buff *skb);
+static int di_napi_poll(struct napi_struct *napi, int budget);
+static void di_queue_ipi(void *info);
+
+static int di_set_nest_opt(struct dummy_iface_params *params,
+			   struct nlattr *nla);
+static int di_set_opt(struct dummy_iface_params *params,
 		      int type, struct nlattr *nla);
 
-#define DI_SET_OPT(_di, _data, _type) do { \
-		int err = di_set_opt(_di, _data, \
+#define DI_SET_OPT(_params, _data, _type) do { \
+		int err = di_set_opt(_params, \
 				 _type, \
 				 _data[_type]); \
 		if (err) \
 			return err;\
 	} while(0)
 
-static const struct nla_policy di_policy[IFLA_DUMMY_IFACE_MAX + 1] = {
+#define DI_ATTR_NEST_MAX	IFLA_DUMMY_IFACE_ATTR_NEST_B
+
+static int di_params_init(struct dummy_iface *di);
+static void di_params_free(struct dummy_iface *di);
+static bool di_params_equal(const struct dummy_iface_params *a,
+			    const struct dummy_iface_params *b);
+static void di_queues_bind(struct dummy_iface *di,
+			   const struct dummy_iface_params *params);
+
+/* Upper bound of IFLA_DUMMY_IFACE_COUNT */
+#define DI_BATCH_MAX		65536
+
+/* Offloads the device advertises, all of them can be toggled with
+ * ethtool -K. Nothing is done in software behind the stack's back: the
+ * frames are consumed or looped back as they were handed over.
+ */
+#define DI_GSO_PARTIAL_FEATURES	(NETIF_F_GSO_GRE | NETIF_F_GSO_GRE_CSUM | \
+				 NETIF_F_GSO_IPXIP4 | NETIF_F_GSO_IPXIP6 | \
+				 NETIF_F_GSO_UDP_TUNNEL | \
+				 NETIF_F_GSO_UDP_TUNNEL_CSUM)
+#define DI_GSO_FEATURES		(NETIF_F_TSO | NETIF_F_TSO6 | \
+				 NETIF_F_GSO_PARTIAL | DI_GSO_PARTIAL_FEATURES)
+#define DI_FEATURES		(NETIF_F_SG | NETIF_F_HW_CSUM | \
+				 NETIF_F_HIGHDMA | DI_GSO_FEATURES)
+
+static const struct nla_policy di_policy[IFLA_DUMMY_IFACE_EXT_MAX + 1] = {
 	[IFLA_DUMMY_IFACE_ATTR_0]	= { .type = NLA_U8 },
 	[IFLA_DUMMY_IFACE_ATTR_1]	= { .type = NLA_U16 },
 	[IFLA_DUMMY_IFACE_ATTR_2]	= { .type = NLA_U32 },
 	[IFLA_DUMMY_IFACE_ATTR_NEST]	= { .type = NLA_NESTED},
 	[IFLA_DUMMY_IFACE_ATTR_BIN]	= { .type = NLA_BINARY,
-					    .len = sizeof(struct ifla_dummy_iface_bin_attr)}
+					    .len = sizeof(struct ifla_dummy_iface_bin_attr)},
+	[IFLA_DUMMY_IFACE_MODE]		= { .type = NLA_U8 },
+	[IFLA_DUMMY_IFACE_COUNT]	= { .type = NLA_U32 },
+	[IFLA_DUMMY_IFACE_DROP]		= { .type = NLA_U32 },
+	[IFLA_DUMMY_IFACE_DELAY]	= { .type = NLA_U32 },
+	[IFLA_DUMMY_IFACE_JITTER]	= { .type = NLA_U32 },
+	[IFLA_DUMMY_IFACE_RATE]		= { .type = NLA_U64 },
+	[IFLA_DUMMY_IFACE_BURST]	= { .type = NLA_U32 },
+	[IFLA_DUMMY_IFACE_QUEUE_CPUS]	= { .type = NLA_BINARY },
+	[IFLA_DUMMY_IFACE_GEN_RATE]	= { .type = NLA_U32 },
+	[IFLA_DUMMY_IFACE_GEN_LEN]	= { .type = NLA_U16 },
+};
+
+static const struct nla_policy di_nest_policy[DI_ATTR_NEST_MAX + 1] = {
+	[IFLA_DUMMY_IFACE_ATTR_NEST_A]	= { .type = NLA_U32 },
+	[IFLA_DUMMY_IFACE_ATTR_NEST_B]	= { .type = NLA_U32 },
 };
 
 struct rtnl_link_ops di_link_ops __read_mostly = {
 	/* Identifier ("interface type") */
-	.kind		= "dummy_iface",
+	.kind		= DUMMY_IFACE_KIND,
 	/* sizeof net_device private space */
 	.priv_size	= sizeof(struct dummy_iface),
 	/* net_device setup function */
 	.setup		= di_setup,
 	/* Highest device specific netlink attribute number */
-	.maxtype	= IFLA_DUMMY_IFACE_MAX,
+	.maxtype	= IFLA_DUMMY_IFACE_EXT_MAX,
 	/* Netlink policy for device specific attribute validation */
 	.policy		= di_policy,
 	/* Optional validation function for netlink/changelink parameters */
@@ -77,23 +143,35 @@ struct rtnl_link_ops di_link_ops __read_mostly = {
 	/* Function for configuring and registering a new device */
 	.newlink	= di_newlink,
 	/* Function for changing parameters of an existing device */
-	.changelink	= di_changelink,
+	.changelink	= di_changelink_op,
 	/* Function to remove a device */
 	.dellink	= di_dellink,
 	/* Function to calculate required room for dumping device specific netlink attributes */
 	.get_size	= di_get_size,
 	/* Function to dump device specific netlink attributes */
 	.fill_info	= di_fill_info,
+	/* Function to determine number of transmit queues to create when
+	 * creating a new device (IFLA_NUM_TX_QUEUES takes precedence) */
+	.get_num_tx_queues = di_get_num_tx_queues,
+	/* Same for receive queues (IFLA_NUM_RX_QUEUES takes precedence) */
+	.get_num_rx_queues = di_get_num_rx_queues,
 };
 
 static const struct net_device_ops di_netdev_ops = {
 	.ndo_init		= di_dev_init,
 	.ndo_uninit		= di_dev_uninit,
-	//.ndo_start_xmit		= ,
+	.ndo_open		= di_dev_open,
+	.ndo_stop		= di_dev_stop,
+	.ndo_start_xmit		= di_xmit,
+	.ndo_select_queue	= di_select_queue,
 	.ndo_validate_addr	= eth_validate_addr,
 	//.ndo_set_rx_mode	= set_multicast_list,
 	.ndo_set_mac_address	= eth_mac_addr,
-	//.ndo_get_stats64	= dummy_get_stats64,
+	.ndo_get_stats64	= di_get_stats64,
+	.ndo_change_mtu		= di_change_mtu,
+	.ndo_fix_features	= di_fix_features,
+	.ndo_set_features	= di_set_features,
+	.ndo_xdp		= dummy_iface_xdp,
 	//.ndo_change_carrier	= dummy_change_carrier,
 };
 
@@ -157,7 +235,7 @@ static void di_setup(struct net_device *dev)
 {
 	struct dummy_iface *di = netdev_priv(dev);
 
-	DI_TRACE_CALL(err);
+	DI_TRACE_CALL(debug);
 
 	/* Fill in the fields of the device structure with Ethernet-generic values. */
 	ether_setup(dev);
@@ -173,7 +251,26 @@ static void di_setup(struct net_device *dev)
 	 */
 	dev->netdev_ops = &di_netdev_ops;
 
+	/* ndo_start_xmit does its own (per-CPU) locking, so the core
+	 * must not serialize transmitters on the tx queue lock.
+	 */
+	dev->features |= NETIF_F_LLTX;
+
+	/* No qdisc either: there is no ring to fill, ndo_start_xmit never
+	 * pushes back, so a queue would only add its root lock and an
+	 * enqueue/dequeue per frame.
+	 */
+	dev->priv_flags |= IFF_NO_QUEUE;
+
+	dev->features |= DI_FEATURES;
+	dev->hw_features |= DI_FEATURES;
+	dev->hw_enc_features |= DI_FEATURES;
+	dev->vlan_features |= DI_FEATURES;
+	dev->gso_partial_features = DI_GSO_PARTIAL_FEATURES;
+
 	di->dev = dev;
+	INIT_LIST_HEAD(&di->batch);
+	INIT_LIST_HEAD(&di->net_list);
 
 	eth_hw_addr_random(dev);
 }
@@ -183,7 +280,9 @@ static void di_setup(struct net_device *dev)
  */
 static void di_free(struct net_device *dev)
 {
-	DI_TRACE_CALL(err);
+	DI_TRACE_CALL(debug);
+
+	di_params_free(netdev_priv(dev));
 
 	/* Free network device.
 	 * This function does the last stage of destroying an allocated device
@@ -194,10 +293,17 @@ static void di_free(struct net_device *dev)
 }
 
 /* Optional validation function for netlink/changelink parameters
+ *
+ * Everything di_changelink may reject is checked here, before any
+ * attribute is applied: a changelink either applies all of its
+ * attributes or none.
  */
 static int di_validate(struct nlattr *tb[], struct nlattr *data[])
 {
-	DI_TRACE_CALL(err);
+	struct nlattr *nest_tb[DI_ATTR_NEST_MAX + 1];
+	int err;
+
+	DI_TRACE_CALL(debug);
 
 	if (tb[IFLA_ADDRESS]) {
 		if (nla_len(tb[IFLA_ADDRESS]) != ETH_ALEN)
@@ -205,6 +311,73 @@ static int di_validate(struct nlattr *tb[], struct nlattr *data[])
 		if (!is_valid_ether_addr(nla_data(tb[IFLA_ADDRESS])))
 			return -EADDRNOTAVAIL;
 	}
+
+	if (!data)
+		return 0;
+
+	if (data[IFLA_DUMMY_IFACE_ATTR_NEST]) {
+		err = nla_parse_nested(nest_tb, DI_ATTR_NEST_MAX,
+				       data[IFLA_DUMMY_IFACE_ATTR_NEST],
+				       di_nest_policy);
+		if (err)
+			return err;
+	}
+
+	if (data[IFLA_DUMMY_IFACE_ATTR_BIN] &&
+	    nla_len(data[IFLA_DUMMY_IFACE_ATTR_BIN]) <
+	    sizeof(struct ifla_dummy_iface_bin_attr))
+		return -EINVAL;
+
+	if (data[IFLA_DUMMY_IFACE_MODE] &&
+	    nla_get_u8(data[IFLA_DUMMY_IFACE_MODE]) > DUMMY_IFACE_MODE_MAX)
+		return -EINVAL;
+
+	if (data[IFLA_DUMMY_IFACE_DELAY] &&
+	    nla_get_u32(data[IFLA_DUMMY_IFACE_DELAY]) > DI_DELAY_MAX_US)
+		return -ERANGE;
+
+	if (data[IFLA_DUMMY_IFACE_JITTER] &&
+	    nla_get_u32(data[IFLA_DUMMY_IFACE_JITTER]) > DI_DELAY_MAX_US)
+		return -ERANGE;
+
+	/* Past one frame per nanosecond the interval would round to 0 */
+	if (data[IFLA_DUMMY_IFACE_GEN_RATE] &&
+	    nla_get_u32(data[IFLA_DUMMY_IFACE_GEN_RATE]) > NSEC_PER_SEC)
+		return -ERANGE;
+
+	if (data[IFLA_DUMMY_IFACE_GEN_LEN]) {
+		u16 len = nla_get_u16(data[IFLA_DUMMY_IFACE_GEN_LEN]);
+
+		/* 0 is ETH_ZLEN, the header and attr_bin fit in that */
+		if (len && (len < ETH_ZLEN || len > ETH_FRAME_LEN))
+			return -EINVAL;
+	}
+
+	if (data[IFLA_DUMMY_IFACE_QUEUE_CPUS]) {
+		const struct nlattr *nla = data[IFLA_DUMMY_IFACE_QUEUE_CPUS];
+		const s32 *cpus = nla_data(nla);
+		int i;
+
+		/* The number of queues is checked by di_changelink */
+		if (nla_len(nla) % sizeof(s32))
+			return -EINVAL;
+		for (i = 0; i < nla_len(nla) / sizeof(s32); i++)
+			if (cpus[i] != -1 &&
+			    (cpus[i] < 0 || cpus[i] >= nr_cpu_ids ||
+			     !cpu_possible(cpus[i])))
+				return -EINVAL;
+	}
+
+	if (data[IFLA_DUMMY_IFACE_COUNT]) {
+		u32 count = nla_get_u32(data[IFLA_DUMMY_IFACE_COUNT]);
+
+		if (count == 0 || count > DI_BATCH_MAX)
+			return -EINVAL;
+		/* Every device of a batch would get the same address */
+		if (count > 1 && tb[IFLA_ADDRESS])
+			return -EINVAL;
+	}
+
 	return 0;
 }
 
@@ -255,53 +428,296 @@ static int di_validate(struct nlattr *tb[], struct nlattr *data[])
  * 	Device specific attributes hold in IFLA_INFO_DATA container.
  *
  * 	Drivers should call register_netdevice from ->newlink
+ *
+ * 	IFLA_DUMMY_IFACE_COUNT > 1 creates a batch of devices with one
+ * 	request, see di_newlink_batch.
+ *
+ * 	@src_net is the namespace of the request (or of IFLA_LINK_NETNSID),
+ * 	where a lower device would be looked up; dummy_iface has none.
+ * 	The device lives in dev_net(dev), the one IFLA_NET_NS_PID/FD
+ * 	selected, and so does everything it is set up with.
  * */
-static int di_newlink(struct net *src_net, /* Device namespace */
+static int di_newlink(struct net *src_net, /* Namespace of the request */
 		      struct net_device *dev,
 		      struct nlattr *tb[], /* system device attributes */
 		      struct nlattr *data[])
 {
+	struct dummy_iface *di = netdev_priv(dev);
+	u32 count = 1;
 	int err;
 
-	DI_TRACE_CALL(err);
+	DI_TRACE_CALL(debug);
+
+	err = di_params_init(di);
+	if (err)
+		return err;
 
 	err = di_changelink(dev, tb, data);
 	if (err < 0)
+		goto err_free;
+
+	if (data && data[IFLA_DUMMY_IFACE_COUNT])
+		count = nla_get_u32(data[IFLA_DUMMY_IFACE_COUNT]);
+
+	if (count > 1)
+		err = di_newlink_batch(dev, tb, data, count);
+	else
+		err = register_netdevice(dev);
+	if (err < 0)
+		goto err_free;
+
+	return 0;
+
+err_free:
+	/* rtnl_newlink frees an unregistered device without ->destructor */
+	di_params_free(di);
+	return err;
+}
+
+/* Resolve the "%d" of @tmpl to the first index, starting at *@idx, that
+ * is not taken in @net. A hash lookup per candidate keeps a batch linear
+ * in its size, where dev_alloc_name() would rescan every device of the
+ * namespace for each new one.
+ */
+static int di_batch_name(struct net *net, const char *tmpl,
+			 int *idx, char *name)
+{
+	for (;; (*idx)++) {
+		if (snprintf(name, IFNAMSIZ, tmpl, *idx) >= IFNAMSIZ)
+			return -ENFILE;
+		if (!__dev_get_by_name(net, name))
+			break;
+	}
+
+	(*idx)++;
+
+	return 0;
+}
+
+/* Create @count devices out of one RTM_NEWLINK. @dev takes the first
+ * name of the "%d" template in its name and becomes the batch leader,
+ * the remaining devices are created with the same link attributes and
+ * registered before it, so that a failure can roll the whole batch back
+ * before rtnl_newlink sees an error.
+ *
+ * Each device is fully configured before it is registered: the batch
+ * costs exactly one RTM_NEWLINK notification per device. Deleting the
+ * leader takes the whole batch down (di_dellink).
+ *
+ * ->newlink does not see the ifinfomsg of the request: its flags (up)
+ * are applied by rtnl_newlink to the leader only, the other devices of
+ * the batch are created down.
+ */
+static int di_newlink_batch(struct net_device *dev,
+			    struct nlattr *tb[],
+			    struct nlattr *data[],
+			    u32 count)
+{
+	struct dummy_iface *di = netdev_priv(dev);
+	struct dummy_iface *peer_di;
+	struct net *net = dev_net(dev);
+	char tmpl[IFNAMSIZ];
+	int idx = 0;
+	LIST_HEAD(list_kill);
+	LIST_HEAD(batch);
+	const char *p;
+	int err;
+	u32 i;
+
+	/* The template is used as a format string below: accept exactly
+	 * what dev_alloc_name() accepts, a single "%d".
+	 */
+	p = strnchr(dev->name, IFNAMSIZ - 1, '%');
+	if (!p || p[1] != 'd' || strchr(p + 2, '%'))
+		return -EINVAL;
+
+	strlcpy(tmpl, dev->name, IFNAMSIZ);
+
+	err = di_batch_name(net, tmpl, &idx, dev->name);
+	if (err)
 		return err;
 
-	return register_netdevice(dev);
+	for (i = 1; i < count; i++) {
+		char name[IFNAMSIZ];
+		struct net_device *peer;
+
+		err = di_batch_name(net, tmpl, &idx, name);
+		if (err)
+			goto err_unregister;
+
+		peer = rtnl_create_link(net, name, NET_NAME_ENUM,
+					&di_link_ops, tb);
+		if (IS_ERR(peer)) {
+			err = PTR_ERR(peer);
+			goto err_unregister;
+		}
+
+		peer_di = netdev_priv(peer);
+
+		err = di_params_init(peer_di);
+		if (!err)
+			err = di_changelink(peer, tb, data);
+		if (!err)
+			err = register_netdevice(peer);
+		if (err < 0) {
+			di_params_free(peer_di);
+			free_netdev(peer);
+			goto err_unregister;
+		}
+
+		list_add_tail(&peer_di->batch, &batch);
+
+		err = rtnl_configure_link(peer, NULL);
+		if (err < 0)
+			goto err_unregister;
+	}
+
+	err = register_netdevice(dev);
+	if (err < 0)
+		goto err_unregister;
+
+	list_splice(&batch, &di->batch);
+	di->batch_leader = true;
+
+	return 0;
+
+err_unregister:
+	list_for_each_entry(peer_di, &batch, batch)
+		unregister_netdevice_queue(peer_di->dev, &list_kill);
+	unregister_netdevice_many(&list_kill);
+
+	return err;
 }
 
 
+/* Attributes were checked by di_validate. They are applied to a copy of
+ * the parameters which is published in place of the current ones.
+ *
+ * rtnl_newlink follows every successful ->changelink with
+ * netdev_state_change(), which notifies an up device (NETDEV_CHANGE and
+ * RTM_NEWLINK) whether anything changed or not. A down device is only
+ * announced by us, with NETDEV_CHANGEINFODATA when a value changed: one
+ * notification per changelink either way.
+ */
 static int di_changelink(struct net_device *dev,
 			   struct nlattr *tb[],
 			   struct nlattr *data[])
 {
 	struct dummy_iface *di = netdev_priv(dev);
+	struct dummy_iface_params params, *old, *new;
+	const s32 *cpus;
+	int err;
 
-	DI_TRACE_CALL(err);
+	DI_TRACE_CALL(debug);
 
 	if (!data)
 		return 0;
 
+	old = rtnl_dereference(di->params);
+	memcpy(&params, old, sizeof(params));
+	cpus = old->queue_cpus;
+
+	if (data[IFLA_DUMMY_IFACE_QUEUE_CPUS]) {
+		const struct nlattr *nla = data[IFLA_DUMMY_IFACE_QUEUE_CPUS];
+
+		params.nr_queue_cpus = nla_len(nla) / sizeof(s32);
+		if (params.nr_queue_cpus > dev->num_tx_queues)
+			return -EINVAL;
+		cpus = nla_data(nla);
+	}
+
 	if (data[IFLA_DUMMY_IFACE_ATTR_0])
-		DI_SET_OPT(di, data, IFLA_DUMMY_IFACE_ATTR_0);
+		DI_SET_OPT(&params, data, IFLA_DUMMY_IFACE_ATTR_0);
 
 	if (data[IFLA_DUMMY_IFACE_ATTR_1])
-		DI_SET_OPT(di, data, IFLA_DUMMY_IFACE_ATTR_1);
+		DI_SET_OPT(&params, data, IFLA_DUMMY_IFACE_ATTR_1);
 
 	if (data[IFLA_DUMMY_IFACE_ATTR_2])
-		DI_SET_OPT(di, data, IFLA_DUMMY_IFACE_ATTR_2);
+		DI_SET_OPT(&params, data, IFLA_DUMMY_IFACE_ATTR_2);
 
 	if (data[IFLA_DUMMY_IFACE_ATTR_NEST])
-		DI_SET_OPT(di, data, IFLA_DUMMY_IFACE_ATTR_NEST);
+		DI_SET_OPT(&params, data, IFLA_DUMMY_IFACE_ATTR_NEST);
 
 	if (data[IFLA_DUMMY_IFACE_ATTR_BIN])
-		DI_SET_OPT(di, data, IFLA_DUMMY_IFACE_ATTR_BIN);
+		DI_SET_OPT(&params, data, IFLA_DUMMY_IFACE_ATTR_BIN);
+
+	if (data[IFLA_DUMMY_IFACE_MODE])
+		DI_SET_OPT(&params, data, IFLA_DUMMY_IFACE_MODE);
+
+	if (data[IFLA_DUMMY_IFACE_DROP])
+		DI_SET_OPT(&params, data, IFLA_DUMMY_IFACE_DROP);
+
+	if (data[IFLA_DUMMY_IFACE_DELAY])
+		DI_SET_OPT(&params, data, IFLA_DUMMY_IFACE_DELAY);
+
+	if (data[IFLA_DUMMY_IFACE_JITTER])
+		DI_SET_OPT(&params, data, IFLA_DUMMY_IFACE_JITTER);
+
+	if (data[IFLA_DUMMY_IFACE_RATE])
+		DI_SET_OPT(&params, data, IFLA_DUMMY_IFACE_RATE);
+
+	if (data[IFLA_DUMMY_IFACE_BURST])
+		DI_SET_OPT(&params, data, IFLA_DUMMY_IFACE_BURST);
+
+	if (data[IFLA_DUMMY_IFACE_GEN_RATE])
+		DI_SET_OPT(&params, data, IFLA_DUMMY_IFACE_GEN_RATE);
+
+	if (data[IFLA_DUMMY_IFACE_GEN_LEN])
+		DI_SET_OPT(&params, data, IFLA_DUMMY_IFACE_GEN_LEN);
+
+	if (di_params_equal(&params, old) &&
+	    !memcmp(cpus, old->queue_cpus,
+		    params.nr_queue_cpus * sizeof(*cpus)))
+		return 0;
+
+	/* Each one was checked by di_validate, the sum depends on both */
+	if (params.delay + params.jitter > DI_DELAY_MAX_US)
+		return -ERANGE;
+
+	err = dummy_iface_impair_prepare(di, &params);
+	if (err)
+		return err;
+
+	params.version++;
+	new = kmalloc(sizeof(params) + params.nr_queue_cpus * sizeof(*cpus),
+		      GFP_KERNEL);
+	if (!new)
+		return -ENOMEM;
+
+	memcpy(new, &params, sizeof(params));
+	memcpy(new->queue_cpus, cpus, params.nr_queue_cpus * sizeof(*cpus));
+
+	rcu_assign_pointer(di->params, new);
+	kfree_rcu(old, rcu);
+
+	/* A device being created is bound by di_dev_init */
+	if (di->queues)
+		di_queues_bind(di, new);
+
+	/* A device going up starts it in di_dev_open */
+	if (netif_running(dev))
+		dummy_iface_gen_start(di);
+
+	/* A device being created is announced once by its registration, an
+	 * up one by rtnl_newlink
+	 */
+	if (dev->reg_state == NETREG_REGISTERED && !(dev->flags & IFF_UP))
+		call_netdevice_notifiers(NETDEV_CHANGEINFODATA, dev);
 
 	return 0;
 }
 
+/* ->changelink: a batch is only ever created, there is no count to change */
+static int di_changelink_op(struct net_device *dev,
+			    struct nlattr *tb[],
+			    struct nlattr *data[])
+{
+	if (data && data[IFLA_DUMMY_IFACE_COUNT])
+		return -EOPNOTSUPP;
+
+	return di_changelink(dev, tb, data);
+}
+
 /*         -----------------
  *        |                 |
  *        |   rtnl_dellink  |
@@ -318,26 +734,47 @@ static int di_changelink(struct net_device *dev,
  *
  * dellink:
  * 	Function to remove a device
+ *
+ * 	Removing a batch leader queues every device of its batch on @head,
+ * 	so rtnl_dellink tears the batch down with a single
+ * 	unregister_netdevice_many() call.
  */
 static void di_dellink(struct net_device *dev,
 			 struct list_head *head)
 {
-	DI_TRACE_CALL(err);
+	struct dummy_iface *di = netdev_priv(dev);
+	struct dummy_iface *peer_di;
+
+	DI_TRACE_CALL(debug);
+
+	if (di->batch_leader)
+		list_for_each_entry(peer_di, &di->batch, batch)
+			unregister_netdevice_queue(peer_di->dev, head);
 
 	unregister_netdevice_queue(dev, head);
 }
 
+/* di_get_size and di_fill_info run for every device of every link dump,
+ * keep them free of tracing.
+ */
 static size_t di_get_size(const struct net_device *dev)
 {
-	DI_TRACE_CALL(err);
-
 	return nla_total_size(sizeof(__u8)) + /* IFLA_DUMMY_IFACE_ATTR_0 */
 		nla_total_size(sizeof(__u16)) + /* IFLA_DUMMY_IFACE_ATTR_1 */
 		nla_total_size(sizeof(__u32)) + /* IFLA_DUMMY_IFACE_ATTR_1 */
 		nla_total_size(sizeof(struct nlattr)) + /* IFLA_DUMMY_IFACE_ATTR_NEST */
 		nla_total_size(sizeof(__u32)) + /* IFLA_DUMMY_IFACE_ATTR_NEST_A */
 		nla_total_size(sizeof(__u32)) + /* IFLA_DUMMY_IFACE_ATTR_NEST_B */
-		nla_total_size(sizeof(struct ifla_dummy_iface_bin_attr)); /* IFLA_DUMMY_IFACE_ATTR_BIN */
+		nla_total_size(sizeof(struct ifla_dummy_iface_bin_attr)) + /* IFLA_DUMMY_IFACE_ATTR_BIN */
+		nla_total_size(sizeof(__u8)) + /* IFLA_DUMMY_IFACE_MODE */
+		nla_total_size(sizeof(__u32)) + /* IFLA_DUMMY_IFACE_DROP */
+		nla_total_size(sizeof(__u32)) + /* IFLA_DUMMY_IFACE_DELAY */
+		nla_total_size(sizeof(__u32)) + /* IFLA_DUMMY_IFACE_JITTER */
+		nla_total_size_64bit(sizeof(__u64)) + /* IFLA_DUMMY_IFACE_RATE */
+		nla_total_size(sizeof(__u32)) + /* IFLA_DUMMY_IFACE_BURST */
+		nla_total_size(sizeof(__u32)) + /* IFLA_DUMMY_IFACE_GEN_RATE */
+		nla_total_size(sizeof(__u16)) + /* IFLA_DUMMY_IFACE_GEN_LEN */
+		nla_total_size(dev->num_tx_queues * sizeof(s32)); /* IFLA_DUMMY_IFACE_QUEUE_CPUS */
 }
 
 static int di_fill_info(struct sk_buff *skb,
@@ -346,130 +783,643 @@ static int di_fill_info(struct sk_buff *skb,
 	int err;
 	struct nlattr *nla_nest;
 	struct dummy_iface *di = netdev_priv(dev);
+	struct dummy_iface_net *dn = dummy_iface_net(dev_net(dev));
+	const struct dummy_iface_params *params;
+	unsigned int start = skb->len;
 
-	DI_TRACE_CALL(err);
+	/* Every value below comes from the same snapshot */
+	rcu_read_lock();
+	params = rcu_dereference(di->params);
 
-	err = nla_put_u8(skb, IFLA_DUMMY_IFACE_ATTR_0, di->params.attr0);
+	err = nla_put_u8(skb, IFLA_DUMMY_IFACE_ATTR_0, params->attr0);
 	if (err)
 		goto err_out;
 
-	err = nla_put_u16(skb, IFLA_DUMMY_IFACE_ATTR_1, di->params.attr1);
+	err = nla_put_u16(skb, IFLA_DUMMY_IFACE_ATTR_1, params->attr1);
 	if (err)
 		goto err_out;
 
-	err = nla_put_u32(skb, IFLA_DUMMY_IFACE_ATTR_2, di->params.attr2);
+	err = nla_put_u32(skb, IFLA_DUMMY_IFACE_ATTR_2, params->attr2);
 	if (err)
 		goto err_out;
 
 	err = nla_put(skb, IFLA_DUMMY_IFACE_ATTR_BIN,
-			sizeof(struct ifla_dummy_iface_bin_attr), &di->params.attr_bin);
+			sizeof(struct ifla_dummy_iface_bin_attr), &params->attr_bin);
 	if (err)
 		goto err_out;
 
 	nla_nest= nla_nest_start(skb, IFLA_DUMMY_IFACE_ATTR_NEST);
-	if (nla_nest == NULL)
+	if (nla_nest == NULL) {
+		err = -EMSGSIZE;
 		goto err_out;
+	}
 
-	err = nla_put_u32(skb, IFLA_DUMMY_IFACE_ATTR_NEST_A, di->params.attr_nest_a);
+	err = nla_put_u32(skb, IFLA_DUMMY_IFACE_ATTR_NEST_A, params->attr_nest_a);
 	if (err)
 		goto err_out;
 
-	err = nla_put_u32(skb, IFLA_DUMMY_IFACE_ATTR_NEST_B, di->params.attr_nest_b);
+	err = nla_put_u32(skb, IFLA_DUMMY_IFACE_ATTR_NEST_B, params->attr_nest_b);
 	if (err)
 		goto err_out;
 
 	nla_nest_end(skb, nla_nest);
 
+	err = nla_put_u8(skb, IFLA_DUMMY_IFACE_MODE, params->mode);
+	if (err)
+		goto err_out;
+
+	err = nla_put_u32(skb, IFLA_DUMMY_IFACE_DROP, params->drop);
+	if (err)
+		goto err_out;
+
+	err = nla_put_u32(skb, IFLA_DUMMY_IFACE_DELAY, params->delay);
+	if (err)
+		goto err_out;
+
+	err = nla_put_u32(skb, IFLA_DUMMY_IFACE_JITTER, params->jitter);
+	if (err)
+		goto err_out;
+
+	err = nla_put_u64_64bit(skb, IFLA_DUMMY_IFACE_RATE, params->rate,
+				IFLA_DUMMY_IFACE_PAD);
+	if (err)
+		goto err_out;
+
+	err = nla_put_u32(skb, IFLA_DUMMY_IFACE_BURST, params->burst);
+	if (err)
+		goto err_out;
+
+	err = nla_put_u32(skb, IFLA_DUMMY_IFACE_GEN_RATE, params->gen_rate);
+	if (err)
+		goto err_out;
+
+	err = nla_put_u16(skb, IFLA_DUMMY_IFACE_GEN_LEN, params->gen_len);
+	if (err)
+		goto err_out;
+
+	/* Left out of the dumps of devices that do not use it */
+	if (params->nr_queue_cpus) {
+		err = nla_put(skb, IFLA_DUMMY_IFACE_QUEUE_CPUS,
+			      params->nr_queue_cpus * sizeof(s32),
+			      params->queue_cpus);
+		if (err)
+			goto err_out;
+	}
+
+	rcu_read_unlock();
+
+	atomic64_inc(&dn->stats.fill_calls);
+	atomic64_add(skb->len - start, &dn->stats.fill_bytes);
+
 	return 0;
 
 err_out:
+	rcu_read_unlock();
 	return err;
 }
 
+/* One tx queue per online CPU: di_select_queue maps every CPU onto
+ * its own queue, so transmitters never share a queue (or its qdisc).
+ */
+static unsigned int di_get_num_tx_queues(void)
+{
+	return num_online_cpus();
+}
+
+/* Loopback frames of tx queue N are recorded as received on rx queue N
+ * (modulo the number of rx queues), one of each per CPU by default.
+ */
+static unsigned int di_get_num_rx_queues(void)
+{
+	return num_online_cpus();
+}
+
+/* Apply IFLA_DUMMY_IFACE_QUEUE_CPUS of @params to the queues. Under
+ * rtnl_lock; the datapath picks the change up at the next kick.
+ */
+static void di_queues_bind(struct dummy_iface *di,
+			   const struct dummy_iface_params *params)
+{
+	unsigned int i;
+
+	for (i = 0; i < di->dev->num_tx_queues; i++)
+		WRITE_ONCE(di->queues[i].cpu, i < params->nr_queue_cpus ?
+			   params->queue_cpus[i] : -1);
+}
+
 static int di_dev_init(struct net_device *dev)
 {
-	DI_TRACE_CALL(err);
+	struct dummy_iface *di = netdev_priv(dev);
+	unsigned int i;
+	int err;
+
+	DI_TRACE_CALL(debug);
+
+	di->stats = netdev_alloc_pcpu_stats(struct dummy_iface_pcpu_stats);
+	if (!di->stats)
+		return -ENOMEM;
+
+	di->queues = kcalloc(dev->num_tx_queues, sizeof(*di->queues),
+			     GFP_KERNEL);
+	if (!di->queues) {
+		free_percpu(di->stats);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < dev->num_tx_queues; i++) {
+		struct dummy_iface_queue *q = &di->queues[i];
+
+		skb_queue_head_init(&q->rxq);
+		dummy_iface_impair_queue_init(q);
+		dummy_iface_gen_queue_init(q);
+		netif_napi_add(dev, &q->napi, di_napi_poll, NAPI_POLL_WEIGHT);
+		q->csd.func = di_queue_ipi;
+		q->csd.info = q;
+	}
+
+	di_queues_bind(di, rtnl_dereference(di->params));
+
+	err = dummy_iface_impair_prepare(di, rtnl_dereference(di->params));
+	if (err) {
+		di_dev_uninit(dev);
+		return err;
+	}
+
+	dummy_iface_net_add(di);
 
 	return 0;
 }
 
 static void di_dev_uninit(struct net_device *dev)
 {
-	DI_TRACE_CALL(err);
+	struct dummy_iface *di = netdev_priv(dev);
+	unsigned int i;
+
+	DI_TRACE_CALL(debug);
+
+	dummy_iface_net_del(di);
+
+	for (i = 0; i < dev->num_tx_queues; i++) {
+		netif_napi_del(&di->queues[i].napi);
+		skb_queue_purge(&di->queues[i].rxq);
+		dummy_iface_xdp_queue_purge(&di->queues[i]);
+		dummy_iface_impair_queue_uninit(&di->queues[i]);
+	}
+
+	dummy_iface_xdp_uninit(di);
+	kfree(di->queues);
+	di->queues = NULL;
+
+	list_del_init(&di->batch);
+	free_percpu(di->stats);
 }
 
-static int di_set_nest_opt(struct dummy_iface *di,
-			   int nest_type,
-			   struct nlattr *data[])
+static int di_dev_open(struct net_device *dev)
 {
-	DI_TRACE_CALL(err);
+	struct dummy_iface *di = netdev_priv(dev);
+	unsigned int i;
 
-	if (nest_type != IFLA_DUMMY_IFACE_ATTR_NEST)
+	for (i = 0; i < dev->num_tx_queues; i++)
+		napi_enable(&di->queues[i].napi);
+
+	netif_tx_start_all_queues(dev);
+	dummy_iface_gen_start(di);
+
+	return 0;
+}
+
+static int di_dev_stop(struct net_device *dev)
+{
+	struct dummy_iface *di = netdev_priv(dev);
+	unsigned int i;
+
+	netif_tx_stop_all_queues(dev);
+
+	for (i = 0; i < dev->num_tx_queues; i++) {
+		napi_disable(&di->queues[i].napi);
+		skb_queue_purge(&di->queues[i].rxq);
+		dummy_iface_xdp_queue_purge(&di->queues[i]);
+		dummy_iface_impair_queue_purge(&di->queues[i]);
+		dummy_iface_gen_queue_purge(&di->queues[i]);
+	}
+
+	return 0;
+}
+
+static int di_change_mtu(struct net_device *dev, int new_mtu)
+{
+	struct dummy_iface *di = netdev_priv(dev);
+
+	/* An attached XDP program needs every frame to fit in one page */
+	if (rtnl_dereference(di->xdp_prog) && new_mtu > DI_XDP_MAX_MTU)
 		return -EINVAL;
 
-	if (data[IFLA_DUMMY_IFACE_ATTR_NEST_A])
-		di->params.attr_nest_a = nla_get_u32(data[IFLA_DUMMY_IFACE_ATTR_NEST_A]);
+	dev->mtu = new_mtu;
 
-	if (data[IFLA_DUMMY_IFACE_ATTR_NEST_B])
-		di->params.attr_nest_b = nla_get_u32(data[IFLA_DUMMY_IFACE_ATTR_NEST_A]);
+	return 0;
+}
+
+static netdev_features_t di_fix_features(struct net_device *dev,
+					 netdev_features_t features)
+{
+	struct dummy_iface *di = netdev_priv(dev);
+
+	/* An attached XDP program needs every frame to fit in one page,
+	 * super-packets would be dropped on their way back.
+	 */
+	if (rtnl_dereference(di->xdp_prog))
+		features &= ~DI_GSO_FEATURES;
+
+	return features;
+}
+
+/* There is no hardware to program: the stack shapes the frames after
+ * dev->features, which the core updates once this returns.
+ */
+static int di_set_features(struct net_device *dev,
+			   netdev_features_t features)
+{
+	netdev_dbg(dev, "features %pNF -> %pNF\n", &dev->features, &features);
 
 	return 0;
 }
 
-static int di_set_opt(struct dummy_iface *di, struct nlattr *data[],
+/* Datapath callbacks below run per packet and are not traced. */
+
+static netdev_tx_t di_xmit(struct sk_buff *skb, struct net_device *dev)
+{
+	struct dummy_iface *di = netdev_priv(dev);
+	struct dummy_iface_pcpu_stats *stats = this_cpu_ptr(di->stats);
+	const struct dummy_iface_params *params;
+	enum dummy_iface_verdict verdict = DUMMY_IFACE_PASS;
+	unsigned int segs = dummy_iface_skb_segs(skb);
+	unsigned int len = dummy_iface_skb_wire_len(skb, segs);
+
+	/* BH disabled is not an RCU read section before 4.20 on preemptible
+	 * RCU, and the snapshot is freed after a normal grace period
+	 */
+	rcu_read_lock();
+	params = rcu_dereference(di->params);
+
+	if (unlikely(dummy_iface_impaired(params)))
+		verdict = dummy_iface_impair(di, params, skb, segs, len);
+
+	/* A dropped frame is counted as tx_dropped only */
+	if (verdict != DUMMY_IFACE_DROPPED) {
+		u64_stats_update_begin(&stats->syncp);
+		stats->tx_packets += segs;
+		stats->tx_bytes += len;
+		u64_stats_update_end(&stats->syncp);
+	}
+
+	if (verdict != DUMMY_IFACE_PASS)
+		goto out;
+
+	if (params->mode == DUMMY_IFACE_MODE_LOOPBACK)
+		di_loopback(di, skb);
+	else
+		dev_kfree_skb(skb);
+out:
+	rcu_read_unlock();
+
+	return NETDEV_TX_OK;
+}
+
+static u16 di_select_queue(struct net_device *dev, struct sk_buff *skb,
+			   void *accel_priv, select_queue_fallback_t fallback)
+{
+	/* Called with BH disabled, the CPU can not change under us */
+	return smp_processor_id() % dev->real_num_tx_queues;
+}
+
+static struct rtnl_link_stats64 *di_get_stats64(struct net_device *dev,
+						struct rtnl_link_stats64 *stats)
+{
+	struct dummy_iface *di = netdev_priv(dev);
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		const struct dummy_iface_pcpu_stats *pcpu;
+		u64 tx_packets, tx_bytes, tx_dropped;
+		u64 rx_packets, rx_bytes, rx_dropped;
+		unsigned int start;
+
+		pcpu = per_cpu_ptr(di->stats, cpu);
+		do {
+			start = u64_stats_fetch_begin_irq(&pcpu->syncp);
+			tx_packets = pcpu->tx_packets;
+			tx_bytes = pcpu->tx_bytes;
+			tx_dropped = pcpu->tx_dropped;
+			rx_packets = pcpu->rx_packets;
+			rx_bytes = pcpu->rx_bytes;
+			rx_dropped = pcpu->rx_dropped;
+		} while (u64_stats_fetch_retry_irq(&pcpu->syncp, start));
+
+		stats->tx_packets += tx_packets;
+		stats->tx_bytes += tx_bytes;
+		stats->tx_dropped += tx_dropped;
+		stats->rx_packets += rx_packets;
+		stats->rx_bytes += rx_bytes;
+		stats->rx_dropped += rx_dropped;
+	}
+
+	return stats;
+}
+
+static void di_queue_ipi(void *info)
+{
+	struct dummy_iface_queue *q = info;
+
+	__napi_schedule(&q->napi);
+}
+
+/* napi_schedule() on the CPU @q is bound to. NAPI_STATE_SCHED is taken
+ * here, so the IPI, and its csd, are only in flight once per poll.
+ */
+void dummy_iface_queue_kick(struct dummy_iface_queue *q)
+{
+	int cpu = READ_ONCE(q->cpu);
+
+	if (!napi_schedule_prep(&q->napi))
+		return;
+
+	if (cpu < 0 || cpu == smp_processor_id() ||
+	    smp_call_function_single_async(cpu, &q->csd))
+		__napi_schedule(&q->napi);
+}
+
+/* DUMMY_IFACE_MODE_LOOPBACK: hand the frame over to the NAPI instance
+ * of its tx queue, which feeds it back to the stack through GRO.
+ */
+static void di_loopback(struct dummy_iface *di, struct sk_buff *skb)
+{
+	struct dummy_iface_queue *q = &di->queues[skb_get_queue_mapping(skb)];
+
+	if (unlikely(skb_queue_len(&q->rxq) >= DI_RX_QUEUE_LEN)) {
+		struct dummy_iface_pcpu_stats *stats = this_cpu_ptr(di->stats);
+
+		u64_stats_update_begin(&stats->syncp);
+		stats->rx_dropped++;
+		u64_stats_update_end(&stats->syncp);
+
+		dev_kfree_skb(skb);
+		return;
+	}
+
+	/* Same device, so no namespace crossing: keep the mark but
+	 * drop the socket, dst and conntrack of the tx side.
+	 */
+	skb_orphan(skb);
+	skb_scrub_packet(skb, false);
+
+	skb_queue_tail(&q->rxq, skb);
+	dummy_iface_queue_kick(q);
+}
+
+/* Feed a loopback frame to XDP, if a program is attached, then to GRO */
+static void di_receive(struct dummy_iface *di, struct dummy_iface_queue *q,
+		       struct bpf_prog *xdp_prog, struct sk_buff *skb)
+{
+	if (xdp_prog) {
+		skb = dummy_iface_xdp_rx(di, q, xdp_prog, skb);
+		if (!skb)
+			return;
+	}
+
+	skb_record_rx_queue(skb, (q - di->queues) % di->dev->real_num_rx_queues);
+	skb->protocol = eth_type_trans(skb, di->dev);
+	napi_gro_receive(&q->napi, skb);
+}
+
+static int di_napi_poll(struct napi_struct *napi, int budget)
+{
+	struct dummy_iface_queue *q = container_of(napi, struct dummy_iface_queue,
+						   napi);
+	struct net_device *dev = napi->dev;
+	struct dummy_iface *di = netdev_priv(dev);
+	const struct dummy_iface_params *params;
+	struct dummy_iface_pcpu_stats *stats;
+	struct sk_buff_head released, generated;
+	struct bpf_prog *xdp_prog;
+	struct sk_buff *skb;
+	u64 packets = 0, bytes = 0;
+	unsigned int segs;
+	u64 expires, gen_expires;
+	int done;
+
+	__skb_queue_head_init(&released);
+	__skb_queue_head_init(&generated);
+
+	rcu_read_lock();
+	params = rcu_dereference(di->params);
+	xdp_prog = rcu_dereference(di->xdp_prog);
+
+	/* Frames whose delay expired go where undelayed ones go */
+	done = dummy_iface_delay_poll(di, q, budget, &released);
+	while ((skb = __skb_dequeue(&released)) != NULL) {
+		if (params->mode != DUMMY_IFACE_MODE_LOOPBACK) {
+			consume_skb(skb);
+			continue;
+		}
+
+		segs = dummy_iface_skb_segs(skb);
+		packets += segs;
+		bytes += dummy_iface_skb_wire_len(skb, segs);
+		di_receive(di, q, xdp_prog, skb);
+	}
+
+	/* Generated frames are received whatever the mode */
+	done += dummy_iface_gen_poll(di, q, params, budget - done, &generated);
+	while ((skb = __skb_dequeue(&generated)) != NULL) {
+		packets++;
+		bytes += skb->len;
+		di_receive(di, q, xdp_prog, skb);
+	}
+
+	while (done < budget && (skb = skb_dequeue(&q->rxq)) != NULL) {
+		done++;
+		segs = dummy_iface_skb_segs(skb);
+		packets += segs;
+		bytes += dummy_iface_skb_wire_len(skb, segs);
+		di_receive(di, q, xdp_prog, skb);
+	}
+
+	rcu_read_unlock();
+
+	/* One counter update per poll rather than per frame */
+	stats = this_cpu_ptr(di->stats);
+	u64_stats_update_begin(&stats->syncp);
+	stats->rx_packets += packets;
+	stats->rx_bytes += bytes;
+	u64_stats_update_end(&stats->syncp);
+
+	if (done < budget) {
+		/* The wheel is ours only until napi_complete() */
+		expires = dummy_iface_delay_arm(q);
+		gen_expires = dummy_iface_gen_arm(q);
+
+		napi_complete(napi);
+
+		/* The xmit path may have queued a frame after the last
+		 * dequeue but before NAPI_STATE_SCHED was cleared, in which
+		 * case its napi_schedule() was a no-op. Same for the timers
+		 * that expired since they were armed.
+		 */
+		smp_mb();
+		if (!skb_queue_empty(&q->rxq) || !skb_queue_empty(&q->delayq) ||
+		    (expires && ktime_get_ns() >= expires) ||
+		    (gen_expires && ktime_get_ns() >= gen_expires))
+			dummy_iface_queue_kick(q);
+	}
+
+	return done;
+}
+
+/* Allocate the initial, all zero, parameters of a device being created */
+static int di_params_init(struct dummy_iface *di)
+{
+	struct dummy_iface_params *params;
+
+	params = kzalloc(sizeof(*params), GFP_KERNEL);
+	if (!params)
+		return -ENOMEM;
+
+	RCU_INIT_POINTER(di->params, params);
+
+	return 0;
+}
+
+/* The device is unregistered or was never registered: no reader left */
+static void di_params_free(struct dummy_iface *di)
+{
+	kfree(rcu_dereference_protected(di->params, 1));
+	RCU_INIT_POINTER(di->params, NULL);
+}
+
+static bool di_params_equal(const struct dummy_iface_params *a,
+			    const struct dummy_iface_params *b)
+{
+	const size_t off = offsetof(struct dummy_iface_params, attr0);
+
+	return !memcmp((const u8 *)a + off, (const u8 *)b + off,
+		       sizeof(*a) - off);
+}
+
+static int di_set_nest_opt(struct dummy_iface_params *params,
+			   struct nlattr *nla)
+{
+	struct nlattr *tb[DI_ATTR_NEST_MAX + 1];
+	int err;
+
+	DI_TRACE_CALL(debug);
+
+	err = nla_parse_nested(tb, DI_ATTR_NEST_MAX, nla, di_nest_policy);
+	if (err)
+		return err;
+
+	if (tb[IFLA_DUMMY_IFACE_ATTR_NEST_A])
+		params->attr_nest_a = nla_get_u32(tb[IFLA_DUMMY_IFACE_ATTR_NEST_A]);
+
+	if (tb[IFLA_DUMMY_IFACE_ATTR_NEST_B])
+		params->attr_nest_b = nla_get_u32(tb[IFLA_DUMMY_IFACE_ATTR_NEST_B]);
+
+	return 0;
+}
+
+static int di_set_opt(struct dummy_iface_params *params,
 		      int type, struct nlattr *nla)
 {
 	int err = 0;
 
-	DI_TRACE_CALL(err);
+	DI_TRACE_CALL(debug);
 
 	switch (type) {
 	case IFLA_DUMMY_IFACE_ATTR_0:
-		di->params.attr0 = nla_get_u8(nla);
+		params->attr0 = nla_get_u8(nla);
 		break;
 	case IFLA_DUMMY_IFACE_ATTR_1:
-		di->params.attr1 = nla_get_u16(nla);
+		params->attr1 = nla_get_u16(nla);
 		break;
 	case IFLA_DUMMY_IFACE_ATTR_2:
-		di->params.attr2 = nla_get_u32(nla);
+		params->attr2 = nla_get_u32(nla);
 		break;
 	case IFLA_DUMMY_IFACE_ATTR_NEST:
-		err = di_set_nest_opt(di, type, nla_data(nla));
+		err = di_set_nest_opt(params, nla);
 		break;
 	case IFLA_DUMMY_IFACE_ATTR_BIN:
-		if (nla_len(nla) < sizeof (struct ifla_dummy_iface_bin_attr))
-			err = -EINVAL;
-		else
-			memcpy(&di->params.attr_bin, nla_data(nla),
-			       sizeof (struct ifla_dummy_iface_bin_attr));
+		memcpy(&params->attr_bin, nla_data(nla),
+		       sizeof (struct ifla_dummy_iface_bin_attr));
+		break;
+	case IFLA_DUMMY_IFACE_MODE:
+		params->mode = nla_get_u8(nla);
+		break;
+	case IFLA_DUMMY_IFACE_DROP:
+		params->drop = nla_get_u32(nla);
+		break;
+	case IFLA_DUMMY_IFACE_DELAY:
+		params->delay = nla_get_u32(nla);
+		break;
+	case IFLA_DUMMY_IFACE_JITTER:
+		params->jitter = nla_get_u32(nla);
+		break;
+	case IFLA_DUMMY_IFACE_RATE:
+		params->rate = nla_get_u64(nla);
+		break;
+	case IFLA_DUMMY_IFACE_BURST:
+		params->burst = nla_get_u32(nla);
+		break;
+	case IFLA_DUMMY_IFACE_GEN_RATE:
+		params->gen_rate = nla_get_u32(nla);
+		break;
+	case IFLA_DUMMY_IFACE_GEN_LEN:
+		params->gen_len = nla_get_u16(nla);
 		break;
 	default:
 		err = -EINVAL;
 	}
 
-	if (!err)
-		call_netdevice_notifiers(NETDEV_CHANGEINFODATA, di->dev);
-
 	return err;
 }
 
 int dummy_iface_netlink_init(void)
 {
+	int err;
+
 	DI_TRACE_CALL(err);
 
-	return rtnl_link_register(&di_link_ops);
+	err = dummy_iface_net_init();
+	if (err)
+		return err;
+
+	err = dummy_iface_genl_init();
+	if (err)
+		goto err_net;
+
+	err = rtnl_link_register(&di_link_ops);
+	if (err)
+		goto err_genl;
+
+	return 0;
+
+err_genl:
+	dummy_iface_genl_fini();
+err_net:
+	dummy_iface_net_fini();
+	return err;
 }
 
 void dummy_iface_netlink_fini(void)
 {
 	DI_TRACE_CALL(err);
 
+	/* Deletes the devices, the genl family reports it */
 	rtnl_link_unregister(&di_link_ops);
+	dummy_iface_genl_fini();
+	dummy_iface_net_fini();
 }
 
-bool is_dummy_iface(struct net_device *dev)
+/* Called for every device from the netdevice notifier */
+bool is_dummy_iface(const struct net_device *dev)
 {
-	DI_TRACE_CALL(err);
-
-	return false;
+	return dev->netdev_ops == &di_netdev_ops;
 }
@@ -0,0 +1,100 @@
+/*
+ * dummy_iface_uapi.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsi
+ *
+ * Driver attributes that follow the IFLA_DUMMY_IFACE_* set declared in
+ * <linux/if_link.h>. Shared between the module and the user space tools.
+ */
+
+#ifndef DUMMY_IFACE_UAPI_H_
+#define DUMMY_IFACE_UAPI_H_
+
+#include <linux/if_link.h>
+
+/* IFLA_INFO_KIND of the devices */
+#define DUMMY_IFACE_KIND		"dummy_iface"
+
+enum {
+	IFLA_DUMMY_IFACE_MODE = IFLA_DUMMY_IFACE_MAX + 1,
+	IFLA_DUMMY_IFACE_COUNT,		/* RTM_NEWLINK only: devices to create */
+	IFLA_DUMMY_IFACE_DROP,		/* u32, P(drop) in 1/2^32, ~0: all */
+	IFLA_DUMMY_IFACE_DELAY,		/* u32, usec */
+	IFLA_DUMMY_IFACE_JITTER,	/* u32, usec, +/- around the delay */
+	IFLA_DUMMY_IFACE_RATE,		/* u64, bytes/s per tx queue, 0: off */
+	IFLA_DUMMY_IFACE_BURST,		/* u32, bytes above RATE, per queue */
+	IFLA_DUMMY_IFACE_PAD,
+	IFLA_DUMMY_IFACE_QUEUE_CPUS,	/* s32[], CPU of each queue, -1: any */
+	IFLA_DUMMY_IFACE_GEN_RATE,	/* u32, rx frames/s per queue, <= 1e9 */
+	IFLA_DUMMY_IFACE_GEN_LEN,	/* u16, generated frame length */
+	__IFLA_DUMMY_IFACE_EXT_MAX,
+};
+
+#define IFLA_DUMMY_IFACE_EXT_MAX (__IFLA_DUMMY_IFACE_EXT_MAX - 1)
+
+/* IFLA_DUMMY_IFACE_MODE values */
+enum dummy_iface_mode {
+	DUMMY_IFACE_MODE_SINK,		/* transmitted frames are freed */
+	DUMMY_IFACE_MODE_LOOPBACK,	/* transmitted frames are received back */
+	__DUMMY_IFACE_MODE_MAX,
+};
+
+#define DUMMY_IFACE_MODE_MAX (__DUMMY_IFACE_MODE_MAX - 1)
+
+/*
+ * Generic netlink family of the module. Its multicast group only carries
+ * dummy_iface devices, so listeners are not woken for every other link
+ * on the host the way RTNLGRP_LINK subscribers are.
+ */
+#define DUMMY_IFACE_GENL_NAME		"dummy_iface"
+#define DUMMY_IFACE_GENL_VERSION	1
+#define DUMMY_IFACE_GENL_MCGRP		"events"
+
+enum {
+	DUMMY_IFACE_CMD_UNSPEC,
+	DUMMY_IFACE_CMD_NEWLINK,	/* event: device registered */
+	DUMMY_IFACE_CMD_DELLINK,	/* event: device unregistered */
+	DUMMY_IFACE_CMD_CHANGELINK,	/* event: params, name, mtu, flags */
+	DUMMY_IFACE_CMD_GETLINK,	/* dump, replied with NEWLINK */
+	DUMMY_IFACE_CMD_GETSTATS,	/* per namespace dump cost */
+	__DUMMY_IFACE_CMD_MAX,
+};
+
+#define DUMMY_IFACE_CMD_MAX (__DUMMY_IFACE_CMD_MAX - 1)
+
+enum {
+	DUMMY_IFACE_A_UNSPEC,
+	DUMMY_IFACE_A_IFINDEX,		/* u32 */
+	DUMMY_IFACE_A_IFNAME,		/* string */
+	DUMMY_IFACE_A_FLAGS,		/* u32, IFF_* */
+	DUMMY_IFACE_A_MTU,		/* u32 */
+	DUMMY_IFACE_A_ADDRESS,		/* binary */
+	DUMMY_IFACE_A_DATA,		/* nested IFLA_DUMMY_IFACE_* */
+	DUMMY_IFACE_A_STATS,		/* nested DUMMY_IFACE_STATS_* */
+	__DUMMY_IFACE_A_MAX,
+};
+
+#define DUMMY_IFACE_A_MAX (__DUMMY_IFACE_A_MAX - 1)
+
+/* What serializing the devices costs, counted since the namespace was
+ * created. FILL_* cover every IFLA_INFO_DATA the module writes, in
+ * RTM_GETLINK dumps, rtnetlink notifications and the family's messages.
+ * DUMP_* cover DUMMY_IFACE_CMD_GETLINK.
+ */
+enum {
+	DUMMY_IFACE_STATS_UNSPEC,
+	DUMMY_IFACE_STATS_PAD,
+	DUMMY_IFACE_STATS_DEVICES,	/* u32, devices in the namespace */
+	DUMMY_IFACE_STATS_FILL_CALLS,	/* u64 */
+	DUMMY_IFACE_STATS_FILL_BYTES,	/* u64 */
+	DUMMY_IFACE_STATS_DUMPS,	/* u64, dumps started */
+	DUMMY_IFACE_STATS_DUMP_MSGS,	/* u64, skbs filled */
+	DUMMY_IFACE_STATS_DUMP_DEVS,	/* u64, devices put */
+	DUMMY_IFACE_STATS_DUMP_NS,	/* u64, time spent filling */
+	__DUMMY_IFACE_STATS_MAX,
+};
+
+#define DUMMY_IFACE_STATS_MAX (__DUMMY_IFACE_STATS_MAX - 1)
+
+#endif /* DUMMY_IFACE_UAPI_H_ */
@@ -0,0 +1,207 @@
+/*
+ * dummy_iface_xdp.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsi
+ */
+
+#define pr_fmt(fmt)	"(dummy iface xdp): " fmt
+
+#include <linux/bpf.h>
+#include <linux/filter.h>
+#include <linux/mm.h>
+#include <linux/netdevice.h>
+#include <linux/rtnetlink.h>
+#include <linux/skbuff.h>
+
+#include "dummy_iface.h"
+
+/*
+ * Native XDP on the loopback receive path.
+ *
+ * A real NIC runs the program on the DMA buffer before any skb exists.
+ * The loopback path mimics that: the transmitted frame is copied into a
+ * page of the queue ("DMA"), the tx skb is released and the program sees
+ * the page. Only XDP_PASS turns the page into an skb (build_skb), the
+ * other verdicts hand the page back to the per-queue page cache, so
+ * XDP_DROP costs one copy and no allocation in steady state.
+ *
+ * XDP_TX sends the frame out of the device. In DUMMY_IFACE_MODE_LOOPBACK
+ * it comes back on the same queue, as on a looped cable, and goes through
+ * the program again; otherwise it is accounted as transmitted and dropped.
+ *
+ * AF_XDP sockets (ndo_xsk_wakeup, XSK buffer pools) are not available on
+ * the kernels this module builds against, which only have ndo_xdp.
+ */
+
+static struct page *di_xdp_page_get(struct dummy_iface_queue *q)
+{
+	if (q->xdp_npages)
+		return q->xdp_pages[--q->xdp_npages];
+
+	return dev_alloc_page();
+}
+
+static void di_xdp_page_put(struct dummy_iface_queue *q, struct page *page)
+{
+	if (q->xdp_npages < DI_XDP_PAGE_CACHE)
+		q->xdp_pages[q->xdp_npages++] = page;
+	else
+		put_page(page);
+}
+
+/* XDP_TX in DUMMY_IFACE_MODE_LOOPBACK: the page becomes an skb again and
+ * is queued behind the frames the poll of @q has yet to receive.
+ */
+static bool di_xdp_tx_loopback(struct dummy_iface *di,
+			       struct dummy_iface_queue *q,
+			       struct page *page,
+			       const struct xdp_buff *xdp)
+{
+	const struct dummy_iface_params *params = rcu_dereference(di->params);
+	struct sk_buff *skb;
+
+	if (params->mode != DUMMY_IFACE_MODE_LOOPBACK ||
+	    skb_queue_len(&q->rxq) >= DI_RX_QUEUE_LEN)
+		return false;
+
+	skb = build_skb(page_address(page), PAGE_SIZE);
+	if (unlikely(!skb))
+		return false;
+
+	skb_reserve(skb, xdp->data - xdp->data_hard_start);
+	skb_put(skb, xdp->data_end - xdp->data);
+	skb_queue_tail(&q->rxq, skb);
+
+	return true;
+}
+
+/* Called from the NAPI poll of @q under rcu_read_lock().
+ * Consumes @skb, returns the skb to receive on XDP_PASS or NULL.
+ */
+struct sk_buff *dummy_iface_xdp_rx(struct dummy_iface *di,
+				   struct dummy_iface_queue *q,
+				   struct bpf_prog *prog,
+				   struct sk_buff *skb)
+{
+	struct dummy_iface_pcpu_stats *stats = this_cpu_ptr(di->stats);
+	unsigned int len = skb->len;
+	struct xdp_buff xdp;
+	struct page *page;
+	u32 act;
+	void *va;
+
+	/* The frame leaves the tx side with a complete checksum, there
+	 * is no offload to finish it once it sits in a page.
+	 */
+	if (unlikely(len > DI_XDP_MAX_FRAME) ||
+	    (skb->ip_summed == CHECKSUM_PARTIAL && skb_checksum_help(skb)))
+		goto drop_skb;
+
+	page = di_xdp_page_get(q);
+	if (unlikely(!page))
+		goto drop_skb;
+
+	va = page_address(page);
+	if (skb_copy_bits(skb, 0, va + DI_XDP_HEADROOM, len)) {
+		di_xdp_page_put(q, page);
+		goto drop_skb;
+	}
+	consume_skb(skb);
+
+	xdp.data_hard_start = va;
+	xdp.data = va + DI_XDP_HEADROOM;
+	xdp.data_end = xdp.data + len;
+
+	act = bpf_prog_run_xdp(prog, &xdp);
+	switch (act) {
+	case XDP_PASS:
+		skb = build_skb(va, PAGE_SIZE);
+		if (unlikely(!skb)) {
+			di_xdp_page_put(q, page);
+			goto drop;
+		}
+		skb_reserve(skb, xdp.data - va);
+		skb_put(skb, xdp.data_end - xdp.data);
+		return skb;
+	case XDP_TX:
+		u64_stats_update_begin(&stats->syncp);
+		stats->tx_packets++;
+		stats->tx_bytes += xdp.data_end - xdp.data;
+		u64_stats_update_end(&stats->syncp);
+		if (!di_xdp_tx_loopback(di, q, page, &xdp))
+			di_xdp_page_put(q, page);
+		return NULL;
+	default:
+		bpf_warn_invalid_xdp_action(act);
+		/* fall through */
+	case XDP_ABORTED:
+	case XDP_DROP:
+		di_xdp_page_put(q, page);
+		goto drop;
+	}
+
+drop_skb:
+	kfree_skb(skb);
+drop:
+	u64_stats_update_begin(&stats->syncp);
+	stats->rx_dropped++;
+	u64_stats_update_end(&stats->syncp);
+	return NULL;
+}
+
+static int di_xdp_set(struct net_device *dev, struct bpf_prog *prog)
+{
+	struct dummy_iface *di = netdev_priv(dev);
+	struct bpf_prog *old_prog;
+
+	if (prog && dev->mtu > DI_XDP_MAX_MTU) {
+		netdev_warn(dev, "MTU %d too large for XDP (max %lu)\n",
+			    dev->mtu, (unsigned long)DI_XDP_MAX_MTU);
+		return -EOPNOTSUPP;
+	}
+
+	/* The reference on @prog is ours from now on */
+	old_prog = rtnl_dereference(di->xdp_prog);
+	rcu_assign_pointer(di->xdp_prog, prog);
+	if (old_prog)
+		bpf_prog_put(old_prog);
+
+	/* No super-packets while a program is attached (di_fix_features) */
+	if (!old_prog != !prog)
+		netdev_update_features(dev);
+
+	return 0;
+}
+
+int dummy_iface_xdp(struct net_device *dev, struct netdev_xdp *xdp)
+{
+	struct dummy_iface *di = netdev_priv(dev);
+
+	switch (xdp->command) {
+	case XDP_SETUP_PROG:
+		return di_xdp_set(dev, xdp->prog);
+	case XDP_QUERY_PROG:
+		xdp->prog_attached = !!rtnl_dereference(di->xdp_prog);
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
+/* Called with the NAPI instance of @q disabled */
+void dummy_iface_xdp_queue_purge(struct dummy_iface_queue *q)
+{
+	while (q->xdp_npages)
+		put_page(q->xdp_pages[--q->xdp_npages]);
+}
+
+/* Called under rtnl_lock from ndo_uninit */
+void dummy_iface_xdp_uninit(struct dummy_iface *di)
+{
+	struct bpf_prog *prog = rtnl_dereference(di->xdp_prog);
+
+	RCU_INIT_POINTER(di->xdp_prog, NULL);
+	if (prog)
+		bpf_prog_put(prog);
+}
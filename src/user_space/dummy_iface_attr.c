@@ -0,0 +1,188 @@
+/*
+ * dummy_iface_attr.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsiv
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <libnl3/netlink/netlink.h>
+#include <libnl3/netlink/errno.h>
+
+#include "dummy_iface_attr.h"
+#include "dummy_iface_nla.h"
+
+#define DI_ATTR(_name, _type, _field)					\
+	{								\
+		.name	= (_name),					\
+		.type	= (_type),					\
+		.offset	= offsetof(struct dummy_iface_params, _field),	\
+		.len	= sizeof(((struct dummy_iface_params *)0)->_field), \
+	}
+
+static const struct dummy_iface_attr di_nest_attrs[IFLA_DUMMY_IFACE_ATTR_NEST_B+1] = {
+	[IFLA_DUMMY_IFACE_ATTR_NEST_A]	= DI_ATTR("NEST_A", NLA_U32, attr_nest_a),
+	[IFLA_DUMMY_IFACE_ATTR_NEST_B]	= DI_ATTR("NEST_B", NLA_U32, attr_nest_b),
+};
+
+const struct dummy_iface_attr dummy_iface_attrs[IFLA_DUMMY_IFACE_EXT_MAX+1] = {
+	[IFLA_DUMMY_IFACE_ATTR_0]	= DI_ATTR("ATTR_0", NLA_U8, attr0),
+	[IFLA_DUMMY_IFACE_ATTR_1]	= DI_ATTR("ATTR_1", NLA_U16, attr1),
+	[IFLA_DUMMY_IFACE_ATTR_2]	= DI_ATTR("ATTR_2", NLA_U32, attr2),
+	[IFLA_DUMMY_IFACE_ATTR_NEST]	= {
+		.name		= "ATTR_NEST",
+		.type		= NLA_NESTED,
+		.nest_max	= IFLA_DUMMY_IFACE_ATTR_NEST_B,
+		.nest		= di_nest_attrs,
+	},
+	[IFLA_DUMMY_IFACE_ATTR_BIN]	= DI_ATTR("ATTR_BIN", NLA_UNSPEC, attr_bin),
+	[IFLA_DUMMY_IFACE_MODE]		= DI_ATTR("MODE", NLA_U8, mode),
+	[IFLA_DUMMY_IFACE_DROP]		= DI_ATTR("DROP", NLA_U32, drop),
+	[IFLA_DUMMY_IFACE_DELAY]	= DI_ATTR("DELAY", NLA_U32, delay),
+	[IFLA_DUMMY_IFACE_JITTER]	= DI_ATTR("JITTER", NLA_U32, jitter),
+	[IFLA_DUMMY_IFACE_RATE]		= DI_ATTR("RATE", NLA_U64, rate),
+	[IFLA_DUMMY_IFACE_BURST]	= DI_ATTR("BURST", NLA_U32, burst),
+	[IFLA_DUMMY_IFACE_GEN_RATE]	= DI_ATTR("GEN_RATE", NLA_U32, gen_rate),
+	[IFLA_DUMMY_IFACE_QUEUE_CPUS]	= DI_ATTR("QUEUE_CPUS", NLA_BINARY, queue_cpus),
+	[IFLA_DUMMY_IFACE_GEN_LEN]	= DI_ATTR("GEN_LEN", NLA_U16, gen_len),
+};
+
+/* The count is kept whole, so that links with more CPUs than we keep
+ * still differ from those with fewer
+ */
+static int di_attr_cpus(struct dummy_iface_cpus *cpus, struct nlattr *nla)
+{
+	int len = di_nla_len(nla);
+
+	if (len % sizeof(int32_t))
+		return -NLE_INVAL;
+
+	memset(cpus, 0, sizeof(*cpus));
+	cpus->nr = len / sizeof(int32_t);
+	memcpy(cpus->cpu, di_nla_data(nla),
+			len < sizeof(cpus->cpu) ? len : sizeof(cpus->cpu));
+
+	return 0;
+}
+
+/* One pass over the attributes in @nla, each one is copied straight to
+ * its place in @params. Unknown attributes are skipped, short ones fail.
+ */
+static int di_attr_walk(const struct dummy_iface_attr *table, int maxtype,
+		struct nlattr *nla, struct dummy_iface_params *params,
+		uint64_t *present)
+{
+	int rem, err;
+	struct nlattr *pos;
+
+	di_nla_for_each_nested(pos, nla, rem) {
+		int type = di_nla_type(pos);
+		int len = di_nla_len(pos);
+		const struct dummy_iface_attr *a;
+
+		if (type > maxtype || !table[type].name)
+			continue;
+		a = &table[type];
+
+		switch (a->type) {
+		case NLA_NESTED:
+			err = di_attr_walk(a->nest, a->nest_max, pos, params,
+					NULL);
+			if (err)
+				return err;
+			break;
+		case NLA_UNSPEC:
+			memcpy((char *)params + a->offset, di_nla_data(pos),
+					len < a->len ? len : a->len);
+			break;
+		case NLA_BINARY:
+			err = di_attr_cpus((struct dummy_iface_cpus *)
+					((char *)params + a->offset), pos);
+			if (err)
+				return err;
+			break;
+		default:
+			if (len < a->len)
+				return -NLE_INVAL;
+			memcpy((char *)params + a->offset, di_nla_data(pos),
+					a->len);
+			break;
+		}
+
+		if (present)
+			*present |= 1ULL << type;
+	}
+
+	return 0;
+}
+
+/* Decode IFLA_INFO_DATA of a dummy_iface link into @params. The bits of
+ * the attributes found are set in @present.
+ */
+int dummy_iface_params_parse(struct nlattr *data,
+		struct dummy_iface_params *params, uint64_t *present)
+{
+	return di_attr_walk(dummy_iface_attrs, IFLA_DUMMY_IFACE_EXT_MAX, data,
+			params, present);
+}
+
+static void di_attr_print(FILE *f, const struct dummy_iface_attr *a,
+		const struct dummy_iface_params *params)
+{
+	const void *v = (const char *)params + a->offset;
+	int i;
+
+	switch (a->type) {
+	case NLA_U8:
+		fprintf(f, "%"PRIu8, *(const uint8_t *)v);
+		break;
+	case NLA_U16:
+		fprintf(f, "%"PRIu16, *(const uint16_t *)v);
+		break;
+	case NLA_U32:
+		fprintf(f, "%"PRIu32, *(const uint32_t *)v);
+		break;
+	case NLA_U64:
+		fprintf(f, "%"PRIu64, *(const uint64_t *)v);
+		break;
+	case NLA_BINARY: {
+		const struct dummy_iface_cpus *cpus = v;
+
+		for (i = 0; i < cpus->nr && i < DI_QUEUE_CPUS; ++i)
+			fprintf(f, "%s%"PRId32, i ? "," : "", cpus->cpu[i]);
+		if (cpus->nr > DI_QUEUE_CPUS)
+			fprintf(f, ",... (%"PRIu32")", cpus->nr);
+		break;
+	}
+	case NLA_NESTED:
+		for (i = 1; i <= a->nest_max; ++i) {
+			if (!a->nest[i].name)
+				continue;
+			fprintf(f, "%s%s ", i > 1 ? " " : "", a->nest[i].name);
+			di_attr_print(f, &a->nest[i], params);
+		}
+		break;
+	default:
+		for (i = 0; i < a->len; ++i)
+			fprintf(f, "%02x", ((const uint8_t *)v)[i]);
+		break;
+	}
+}
+
+void dummy_iface_params_print(FILE *f, const struct dummy_iface_params *params,
+		uint64_t present)
+{
+	int i;
+
+	for (i = 1; i <= IFLA_DUMMY_IFACE_EXT_MAX; ++i) {
+		if (!(present & (1ULL << i)) || !dummy_iface_attrs[i].name)
+			continue;
+
+		fprintf(f, "    %s: ", dummy_iface_attrs[i].name);
+		di_attr_print(f, &dummy_iface_attrs[i], params);
+		fprintf(f, "\n");
+	}
+}
@@ -0,0 +1,42 @@
+/*
+ * dummy_iface_attr.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsiv
+ *
+ * Decoding of the IFLA_DUMMY_IFACE_* attributes (IFLA_INFO_DATA of a
+ * dummy_iface link), shared by the user space tools.
+ */
+
+#ifndef SRC_USER_SPACE_DUMMY_IFACE_ATTR_H_
+#define SRC_USER_SPACE_DUMMY_IFACE_ATTR_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <libnl3/netlink/attr.h>
+
+#include "dummy_iface_link.h"
+
+/* How an attribute is stored in struct dummy_iface_params: @type is the
+ * NLA_* type, NLA_UNSPEC copies at most @len bytes, NLA_BINARY is an s32
+ * array kept as a struct dummy_iface_cpus, NLA_NESTED is walked with
+ * @nest. Attributes without a @name are skipped.
+ */
+struct dummy_iface_attr {
+	const char *name;
+	uint16_t type;
+	uint16_t offset;
+	uint16_t len;
+	uint16_t nest_max;
+	const struct dummy_iface_attr *nest;
+};
+
+extern const struct dummy_iface_attr dummy_iface_attrs[IFLA_DUMMY_IFACE_EXT_MAX+1];
+
+int dummy_iface_params_parse(struct nlattr *data,
+		struct dummy_iface_params *params, uint64_t *present);
+void dummy_iface_params_print(FILE *f, const struct dummy_iface_params *params,
+		uint64_t present);
+
+#endif /* SRC_USER_SPACE_DUMMY_IFACE_ATTR_H_ */
@@ -0,0 +1,81 @@
+/*
+ * dummy_iface_bufpool.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsiv
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "dummy_iface_bufpool.h"
+
+struct dummy_iface_bufpool *dummy_iface_bufpool_create(uint32_t nr,
+		size_t size)
+{
+	struct dummy_iface_bufpool *pool;
+	long page = sysconf(_SC_PAGESIZE);
+	uint32_t i;
+
+	if (!nr || (nr & (nr - 1))) {
+		fprintf(stderr, "Buffer pool size must be a power of 2\n");
+		return NULL;
+	}
+
+	size = (size + page - 1) & ~(size_t)(page - 1);
+
+	if (posix_memalign((void **)&pool, 64,
+			sizeof(*pool) + nr * sizeof(pool->bufs[0]))) {
+		fprintf(stderr, "Failed to allocate buffer pool\n");
+		return NULL;
+	}
+	memset(pool, 0, sizeof(*pool) + nr * sizeof(pool->bufs[0]));
+
+	if (posix_memalign((void **)&pool->mem, page, nr * size)) {
+		fprintf(stderr, "Failed to allocate buffer pool\n");
+		free(pool);
+		return NULL;
+	}
+
+	pool->nr = nr;
+	pool->size = size;
+	for (i = 0; i < nr; ++i)
+		pool->bufs[i].data = pool->mem + i * size;
+
+	return pool;
+}
+
+void dummy_iface_bufpool_destroy(struct dummy_iface_bufpool *pool)
+{
+	if (!pool)
+		return;
+
+	free(pool->mem);
+	free(pool);
+}
+
+/* Buffers are dropped about in the order they were taken, the one after
+ * the last taken is most likely free.
+ */
+struct dummy_iface_buf *dummy_iface_bufpool_get(struct dummy_iface_bufpool *pool)
+{
+	struct dummy_iface_buf *buf;
+	uint32_t n;
+
+	for (n = 1; ; ++n) {
+		buf = &pool->bufs[pool->next++ & (pool->nr - 1)];
+		if (!__atomic_load_n(&buf->refs, __ATOMIC_ACQUIRE)) {
+			buf->refs = 1;
+			return buf;
+		}
+
+		/* Every one held: let the workers drop some */
+		if (!(n & (pool->nr - 1))) {
+			pool->stalls++;
+			sched_yield();
+		}
+	}
+}
@@ -0,0 +1,57 @@
+/*
+ * dummy_iface_bufpool.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsiv
+ *
+ * Receive buffers of the listener's event loop: page aligned, allocated
+ * once and recycled, so receiving costs no allocation. A buffer is held
+ * by reference while messages in it are in flight: the decode workers
+ * (-t) take one per message and drop it once the message is decoded in
+ * place, no message is copied on its way to them. Only the receive
+ * thread takes buffers from the pool.
+ */
+
+#ifndef SRC_USER_SPACE_DUMMY_IFACE_BUFPOOL_H_
+#define SRC_USER_SPACE_DUMMY_IFACE_BUFPOOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct dummy_iface_buf {
+	char *data;
+	int refs;		/* free at 0 */
+} __attribute__((aligned(64)));
+
+struct dummy_iface_bufpool {
+	uint32_t nr;		/* power of 2 */
+	uint32_t next;		/* where to look for a free buffer */
+	size_t size;		/* of a buffer, a multiple of the page size */
+	unsigned long stalls;	/* times every buffer was held */
+	char *mem;
+	struct dummy_iface_buf bufs[];
+};
+
+struct dummy_iface_bufpool *dummy_iface_bufpool_create(uint32_t nr,
+		size_t size);
+void dummy_iface_bufpool_destroy(struct dummy_iface_bufpool *pool);
+/* A free buffer, held once. Waits for one to be dropped if none is. */
+struct dummy_iface_buf *dummy_iface_bufpool_get(struct dummy_iface_bufpool *pool);
+
+static inline void dummy_iface_buf_hold(struct dummy_iface_buf *buf)
+{
+	__atomic_add_fetch(&buf->refs, 1, __ATOMIC_RELAXED);
+}
+
+/* Whatever was read from the buffer is done with before it is reused */
+static inline void dummy_iface_buf_put(struct dummy_iface_buf *buf)
+{
+	__atomic_sub_fetch(&buf->refs, 1, __ATOMIC_RELEASE);
+}
+
+static inline int dummy_iface_buf_shared(struct dummy_iface_buf *buf)
+{
+	return __atomic_load_n(&buf->refs, __ATOMIC_ACQUIRE) > 1;
+}
+
+#endif /* SRC_USER_SPACE_DUMMY_IFACE_BUFPOOL_H_ */
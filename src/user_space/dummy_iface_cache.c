@@ -0,0 +1,237 @@
+/*
+ * dummy_iface_cache.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsiv
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <linux/rtnetlink.h>
+
+#include "dummy_iface_cache.h"
+
+static size_t di_cache_size(uint32_t capacity)
+{
+	return sizeof(struct dummy_iface_cache) +
+		(size_t)capacity * sizeof(struct dummy_iface_cache_entry);
+}
+
+/* @name is a shared memory object, NULL keeps the cache private */
+struct dummy_iface_cache *dummy_iface_cache_open(const char *name,
+		uint32_t capacity)
+{
+	int fd;
+	size_t size;
+	struct dummy_iface_cache *c;
+
+	if (!capacity || (capacity & (capacity - 1))) {
+		fprintf(stderr, "Cache capacity must be a power of 2\n");
+		return NULL;
+	}
+
+	size = di_cache_size(capacity);
+
+	if (!name) {
+		c = mmap(NULL, size, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	} else {
+		fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0) {
+			perror("Failed to open shared memory");
+			return NULL;
+		}
+
+		if (ftruncate(fd, size)) {
+			perror("Failed to size shared memory");
+			close(fd);
+			return NULL;
+		}
+
+		c = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+	}
+
+	if (c == MAP_FAILED) {
+		perror("Failed to map link cache");
+		return NULL;
+	}
+
+	c->version = DUMMY_IFACE_CACHE_VERSION;
+	c->entry_size = sizeof(struct dummy_iface_cache_entry);
+	c->capacity = capacity;
+	/* Readers check the magic last */
+	__atomic_store_n(&c->magic, DUMMY_IFACE_CACHE_MAGIC, __ATOMIC_RELEASE);
+
+	return c;
+}
+
+void dummy_iface_cache_close(struct dummy_iface_cache *c)
+{
+	if (c)
+		munmap(c, di_cache_size(c->capacity));
+}
+
+static void di_cache_write_begin(struct dummy_iface_cache_entry *e)
+{
+	__atomic_store_n(&e->seq, e->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void di_cache_write_end(struct dummy_iface_cache_entry *e)
+{
+	__atomic_store_n(&e->seq, e->seq + 1, __ATOMIC_RELEASE);
+}
+
+/* Slot of @ifindex, or the slot to insert it at (the first deleted one on
+ * the way, else the empty one that ended the probe). NULL if full.
+ */
+static struct dummy_iface_cache_entry *di_cache_find(struct dummy_iface_cache *c,
+		int32_t ifindex, bool *found)
+{
+	struct dummy_iface_cache_entry *e, *slot = NULL;
+	uint32_t i, n;
+
+	*found = false;
+
+	for (i = dummy_iface_cache_hash(c, ifindex), n = 0; n < c->capacity;
+			i = (i + 1) & (c->capacity - 1), n++) {
+		e = &c->entry[i];
+
+		if (e->ifindex == ifindex) {
+			*found = true;
+			return e;
+		}
+		if (e->ifindex == DI_CACHE_DELETED && !slot)
+			slot = e;
+		if (e->ifindex == DI_CACHE_EMPTY)
+			return slot ? slot : e;
+	}
+
+	return slot;
+}
+
+static void di_cache_set(struct dummy_iface_cache *c,
+		struct dummy_iface_cache_entry *e,
+		const struct dummy_iface_link *link)
+{
+	di_cache_write_begin(e);
+	memcpy(&e->link, link, sizeof(e->link));
+	e->epoch = c->epoch;
+	__atomic_store_n(&e->ifindex, link->ifindex, __ATOMIC_RELAXED);
+	di_cache_write_end(e);
+}
+
+static void di_cache_delete(struct dummy_iface_cache *c,
+		struct dummy_iface_cache_entry *e)
+{
+	di_cache_write_begin(e);
+	__atomic_store_n(&e->ifindex, DI_CACHE_DELETED, __ATOMIC_RELAXED);
+	di_cache_write_end(e);
+
+	c->count--;
+	c->deleted++;
+}
+
+/* Deleted slots lengthen probes and are only reused by inserts that pass
+ * them, so the table is rebuilt without them once they pile up.
+ */
+static int di_cache_rebuild(struct dummy_iface_cache *c)
+{
+	struct dummy_iface_link *live;
+	uint32_t i, n = 0;
+	bool found;
+
+	live = malloc((size_t)c->count * sizeof(*live) + 1);
+	if (!live)
+		return -1;
+
+	for (i = 0; i < c->capacity; ++i)
+		if (c->entry[i].ifindex > 0)
+			memcpy(&live[n++], &c->entry[i].link, sizeof(*live));
+
+	__atomic_store_n(&c->seq, c->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	for (i = 0; i < c->capacity; ++i)
+		c->entry[i].ifindex = DI_CACHE_EMPTY;
+
+	for (i = 0; i < n; ++i)
+		di_cache_set(c, di_cache_find(c, live[i].ifindex, &found),
+				&live[i]);
+
+	c->deleted = 0;
+	__atomic_store_n(&c->seq, c->seq + 1, __ATOMIC_RELEASE);
+
+	free(live);
+
+	return 0;
+}
+
+/* Apply an RTM_NEWLINK (insert or update in place) or RTM_DELLINK */
+int dummy_iface_cache_update(struct dummy_iface_cache *c,
+		const struct dummy_iface_link *link)
+{
+	struct dummy_iface_cache_entry *e;
+	bool found;
+
+	if (link->ifindex <= 0)
+		return 0;
+
+	if (link->type == RTM_DELLINK) {
+		e = di_cache_find(c, link->ifindex, &found);
+		if (found)
+			di_cache_delete(c, e);
+		return 0;
+	}
+
+	if (link->type != RTM_NEWLINK)
+		return 0;
+
+	if ((c->count + c->deleted + 1) * 4ULL > c->capacity * 3ULL &&
+			c->deleted)
+		di_cache_rebuild(c);
+
+	e = di_cache_find(c, link->ifindex, &found);
+	if (!found) {
+		/* Keep probes short: at most 3/4 full */
+		if (!e || (c->count + 1) * 4ULL > c->capacity * 3ULL) {
+			fprintf(stderr, "Link cache full, %d not cached\n",
+					link->ifindex);
+			return -1;
+		}
+		if (e->ifindex == DI_CACHE_DELETED)
+			c->deleted--;
+		c->count++;
+	}
+
+	di_cache_set(c, e, link);
+
+	return 0;
+}
+
+/* A dump is about to start: links it does not report are gone */
+void dummy_iface_cache_dump_begin(struct dummy_iface_cache *c)
+{
+	c->epoch++;
+}
+
+/* Called for a dump that completed and was consistent */
+void dummy_iface_cache_dump_end(struct dummy_iface_cache *c)
+{
+	uint32_t i;
+
+	for (i = 0; i < c->capacity; ++i) {
+		struct dummy_iface_cache_entry *e = &c->entry[i];
+
+		if (e->ifindex > 0 && e->epoch != c->epoch)
+			di_cache_delete(c, e);
+	}
+}
@@ -0,0 +1,111 @@
+/*
+ * dummy_iface_cache.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsiv
+ *
+ * Link state cache kept by the listener: an open addressed (linear
+ * probing) hash table keyed by ifindex, in a shared memory segment so
+ * that local processes can look links up without dumping them from the
+ * kernel. The listener is the only writer. Readers use
+ * dummy_iface_cache_lookup(), which retries if it raced with an update.
+ */
+
+#ifndef SRC_USER_SPACE_DUMMY_IFACE_CACHE_H_
+#define SRC_USER_SPACE_DUMMY_IFACE_CACHE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include "dummy_iface_link.h"
+
+#define DUMMY_IFACE_CACHE_MAGIC		0x64696363	/* "dicc" */
+#define DUMMY_IFACE_CACHE_VERSION	2
+#define DUMMY_IFACE_CACHE_CAPACITY	131072
+
+/* dummy_iface_cache_entry.ifindex of a slot that is not in use */
+#define DI_CACHE_EMPTY		0
+#define DI_CACHE_DELETED	(-1)
+
+struct dummy_iface_cache_entry {
+	uint64_t seq;		/* odd while the entry is written */
+	int32_t ifindex;
+	uint32_t epoch;		/* dump that last saw the link */
+	struct dummy_iface_link link;
+};
+
+struct dummy_iface_cache {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entry_size;
+	uint32_t capacity;	/* power of 2 */
+	uint64_t seq;		/* odd while the table is rebuilt */
+	uint32_t count;
+	uint32_t deleted;
+	uint32_t epoch;
+	uint8_t pad[28];
+	struct dummy_iface_cache_entry entry[];
+};
+
+static inline uint32_t dummy_iface_cache_hash(const struct dummy_iface_cache *c,
+		int32_t ifindex)
+{
+	return ((uint32_t)ifindex * 2654435761u) & (c->capacity - 1);
+}
+
+/* Copy the state of @ifindex into @link. Returns 1 if the link is known,
+ * 0 if it is not.
+ */
+static inline int dummy_iface_cache_lookup(const struct dummy_iface_cache *c,
+		int32_t ifindex, struct dummy_iface_link *link)
+{
+	const struct dummy_iface_cache_entry *e;
+	uint64_t tseq, eseq;
+	uint32_t i, n;
+	int32_t idx;
+
+retry:
+	tseq = __atomic_load_n(&c->seq, __ATOMIC_ACQUIRE);
+	if (tseq & 1)
+		goto retry;
+
+	for (i = dummy_iface_cache_hash(c, ifindex), n = 0; n < c->capacity;
+			i = (i + 1) & (c->capacity - 1), n++) {
+		e = &c->entry[i];
+again:
+		eseq = __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE);
+		if (eseq & 1)
+			goto again;
+
+		idx = __atomic_load_n(&e->ifindex, __ATOMIC_RELAXED);
+		if (idx == DI_CACHE_EMPTY)
+			break;
+		if (idx != ifindex)
+			continue;
+
+		memcpy(link, &e->link, sizeof(*link));
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&e->seq, __ATOMIC_RELAXED) != eseq)
+			goto again;
+		if (__atomic_load_n(&c->seq, __ATOMIC_RELAXED) != tseq)
+			goto retry;
+		return 1;
+	}
+
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if (__atomic_load_n(&c->seq, __ATOMIC_RELAXED) != tseq)
+		goto retry;
+
+	return 0;
+}
+
+struct dummy_iface_cache *dummy_iface_cache_open(const char *name,
+		uint32_t capacity);
+void dummy_iface_cache_close(struct dummy_iface_cache *c);
+int dummy_iface_cache_update(struct dummy_iface_cache *c,
+		const struct dummy_iface_link *link);
+void dummy_iface_cache_dump_begin(struct dummy_iface_cache *c);
+void dummy_iface_cache_dump_end(struct dummy_iface_cache *c);
+
+#endif /* SRC_USER_SPACE_DUMMY_IFACE_CACHE_H_ */
@@ -0,0 +1,220 @@
+/*
+ * dummy_iface_coalesce.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsiv
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "dummy_iface_coalesce.h"
+
+#define DI_NONE		(-1)
+
+/* A pending link. Its @states follow it, @depth of them */
+struct di_coalesce_entry {
+	int32_t ifindex;
+	int32_t hnext;		/* hash chain */
+	int32_t next;		/* pending FIFO, or free list */
+	uint32_t count;		/* states queued */
+	uint32_t merged;	/* events folded into the last one */
+	uint64_t deadline;
+	struct dummy_iface_link states[];
+};
+
+/*
+ * The window is the same for every link, so the pending ones expire in
+ * the order their first event came: a FIFO is all the timer we need.
+ */
+struct dummy_iface_coalesce {
+	uint64_t window;
+	uint32_t depth;
+	uint32_t capacity;	/* power of 2 */
+	size_t entry_size;
+	int32_t *hash;
+	int32_t head, tail;	/* pending, oldest first */
+	int32_t free;
+	dummy_iface_deliver_t deliver;
+	void *arg;
+	char *entries;
+};
+
+static uint64_t di_now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+static struct di_coalesce_entry *di_entry(struct dummy_iface_coalesce *c,
+		int32_t i)
+{
+	return (struct di_coalesce_entry *)(c->entries + i * c->entry_size);
+}
+
+static int32_t *di_bucket(struct dummy_iface_coalesce *c, int32_t ifindex)
+{
+	return &c->hash[((uint32_t)ifindex * 2654435761u) & (c->capacity - 1)];
+}
+
+struct dummy_iface_coalesce *dummy_iface_coalesce_create(uint32_t window_ms,
+		uint32_t depth, uint32_t capacity,
+		dummy_iface_deliver_t deliver, void *arg)
+{
+	struct dummy_iface_coalesce *c;
+	uint32_t i;
+
+	if (!capacity || (capacity & (capacity - 1))) {
+		fprintf(stderr, "Coalescing capacity must be a power of 2\n");
+		return NULL;
+	}
+	if (!depth || depth > DUMMY_IFACE_COALESCE_DEPTH_MAX) {
+		fprintf(stderr, "Coalescing depth must be 1 to %d\n",
+				DUMMY_IFACE_COALESCE_DEPTH_MAX);
+		return NULL;
+	}
+
+	c = calloc(1, sizeof(*c));
+	if (!c)
+		return NULL;
+
+	c->window = window_ms;
+	c->depth = depth;
+	c->capacity = capacity;
+	c->entry_size = sizeof(struct di_coalesce_entry) +
+		depth * sizeof(struct dummy_iface_link);
+	c->deliver = deliver;
+	c->arg = arg;
+	c->hash = malloc(capacity * sizeof(*c->hash));
+	c->entries = malloc(capacity * c->entry_size);
+	if (!c->hash || !c->entries) {
+		perror("Failed to allocate coalescing table");
+		dummy_iface_coalesce_destroy(c);
+		return NULL;
+	}
+
+	memset(c->hash, DI_NONE, capacity * sizeof(*c->hash));
+	for (i = 0; i < capacity; ++i)
+		di_entry(c, i)->next = i + 1 < capacity ? i + 1 : DI_NONE;
+	c->free = 0;
+	c->head = c->tail = DI_NONE;
+
+	return c;
+}
+
+void dummy_iface_coalesce_destroy(struct dummy_iface_coalesce *c)
+{
+	if (!c)
+		return;
+
+	free(c->hash);
+	free(c->entries);
+	free(c);
+}
+
+static int32_t di_coalesce_find(struct dummy_iface_coalesce *c,
+		int32_t ifindex)
+{
+	int32_t i;
+
+	for (i = *di_bucket(c, ifindex); i != DI_NONE; i = di_entry(c, i)->hnext)
+		if (di_entry(c, i)->ifindex == ifindex)
+			return i;
+
+	return DI_NONE;
+}
+
+/* Deliver the oldest pending link and give its entry back */
+static void di_coalesce_pop(struct dummy_iface_coalesce *c)
+{
+	int32_t i = c->head, *pos;
+	struct di_coalesce_entry *e = di_entry(c, i);
+	uint32_t n;
+
+	for (n = 0; n < e->count; ++n)
+		c->deliver(&e->states[n], n + 1 == e->count ? e->merged : 0,
+				c->arg);
+
+	for (pos = di_bucket(c, e->ifindex); *pos != i;
+	     pos = &di_entry(c, *pos)->hnext)
+		;
+	*pos = e->hnext;
+
+	c->head = e->next;
+	if (c->head == DI_NONE)
+		c->tail = DI_NONE;
+
+	e->next = c->free;
+	c->free = i;
+}
+
+void dummy_iface_coalesce_add(struct dummy_iface_coalesce *c,
+		const struct dummy_iface_link *link)
+{
+	struct di_coalesce_entry *e;
+	int32_t i, *bucket;
+
+	i = di_coalesce_find(c, link->ifindex);
+	if (i != DI_NONE) {
+		e = di_entry(c, i);
+		if (e->count < c->depth) {
+			e->states[e->count++] = *link;
+			e->merged = 0;
+		} else {
+			e->states[e->count - 1] = *link;
+			e->merged++;
+		}
+		return;
+	}
+
+	/* Full: the oldest one goes out before its window is over */
+	if (c->free == DI_NONE)
+		di_coalesce_pop(c);
+
+	i = c->free;
+	e = di_entry(c, i);
+	c->free = e->next;
+
+	bucket = di_bucket(c, link->ifindex);
+	e->ifindex = link->ifindex;
+	e->hnext = *bucket;
+	*bucket = i;
+
+	e->count = 1;
+	e->merged = 0;
+	e->states[0] = *link;
+	e->deadline = di_now_ms() + c->window;
+
+	e->next = DI_NONE;
+	if (c->tail != DI_NONE)
+		di_entry(c, c->tail)->next = i;
+	else
+		c->head = i;
+	c->tail = i;
+}
+
+int dummy_iface_coalesce_run(struct dummy_iface_coalesce *c)
+{
+	uint64_t now = di_now_ms();
+
+	while (c->head != DI_NONE) {
+		uint64_t deadline = di_entry(c, c->head)->deadline;
+
+		if (deadline > now)
+			return deadline - now;
+		di_coalesce_pop(c);
+	}
+
+	return -1;
+}
+
+void dummy_iface_coalesce_flush(struct dummy_iface_coalesce *c)
+{
+	while (c->head != DI_NONE)
+		di_coalesce_pop(c);
+}
@@ -0,0 +1,46 @@
+/*
+ * dummy_iface_coalesce.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsiv
+ *
+ * Coalescing stage of the listener. The events of a link are held for a
+ * window from the first one and only its latest states are delivered
+ * when it expires, so a flapping link costs the consumers at most @depth
+ * states per window, however many it went through. Each link queues up
+ * to @depth states, a newer one replaces the last queued when it is
+ * full. Links pending at once are bounded by @capacity, the oldest one
+ * is delivered early to make room.
+ */
+
+#ifndef SRC_USER_SPACE_DUMMY_IFACE_COALESCE_H_
+#define SRC_USER_SPACE_DUMMY_IFACE_COALESCE_H_
+
+#include <stdint.h>
+
+#include "dummy_iface_link.h"
+
+#define DUMMY_IFACE_COALESCE_CAPACITY	65536
+#define DUMMY_IFACE_COALESCE_DEPTH_MAX	64
+
+/* Called for each delivered state, @merged events were folded into it */
+typedef void (*dummy_iface_deliver_t)(const struct dummy_iface_link *link,
+		uint32_t merged, void *arg);
+
+struct dummy_iface_coalesce;
+
+struct dummy_iface_coalesce *dummy_iface_coalesce_create(uint32_t window_ms,
+		uint32_t depth, uint32_t capacity,
+		dummy_iface_deliver_t deliver, void *arg);
+void dummy_iface_coalesce_destroy(struct dummy_iface_coalesce *c);
+
+void dummy_iface_coalesce_add(struct dummy_iface_coalesce *c,
+		const struct dummy_iface_link *link);
+/* Deliver the links whose window expired. Returns the milliseconds until
+ * the next one does, -1 if none is pending.
+ */
+int dummy_iface_coalesce_run(struct dummy_iface_coalesce *c);
+/* Deliver every pending link now */
+void dummy_iface_coalesce_flush(struct dummy_iface_coalesce *c);
+
+#endif /* SRC_USER_SPACE_DUMMY_IFACE_COALESCE_H_ */
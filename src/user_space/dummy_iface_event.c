@@ -0,0 +1,137 @@
+/*
+ * dummy_iface_event.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsiv
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "dummy_iface_event.h"
+
+/* Records are flushed per receive batch, not per record */
+#define DI_EVENT_STREAM_BUF	(1024 * 1024)
+
+int dummy_iface_event_stream_open(struct dummy_iface_event_out *out,
+		const char *path)
+{
+	memset(out, 0, sizeof(*out));
+
+	if (!strcmp(path, "-"))
+		out->stream = stdout;
+	else
+		out->stream = fopen(path, "wb");
+
+	if (!out->stream) {
+		perror("Failed to open event stream");
+		return -1;
+	}
+
+	setvbuf(out->stream, NULL, _IOFBF, DI_EVENT_STREAM_BUF);
+
+	return 0;
+}
+
+int dummy_iface_event_ring_open(struct dummy_iface_event_out *out,
+		const char *name, uint32_t capacity)
+{
+	int fd;
+	size_t size;
+	void *addr;
+
+	memset(out, 0, sizeof(*out));
+
+	if (!capacity || (capacity & (capacity - 1))) {
+		fprintf(stderr, "Ring capacity must be a power of 2\n");
+		return -1;
+	}
+
+	size = sizeof(struct dummy_iface_ring) +
+		(size_t)capacity * sizeof(struct dummy_iface_ring_slot);
+
+	fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		perror("Failed to open shared memory");
+		return -1;
+	}
+
+	if (ftruncate(fd, size)) {
+		perror("Failed to size shared memory");
+		close(fd);
+		return -1;
+	}
+
+	addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED) {
+		perror("Failed to map shared memory");
+		return -1;
+	}
+
+	out->ring = addr;
+	out->ring_size = size;
+
+	out->ring->version = DUMMY_IFACE_EVENT_VERSION;
+	out->ring->slot_size = sizeof(struct dummy_iface_ring_slot);
+	out->ring->capacity = capacity;
+	/* Readers check the magic last */
+	__atomic_store_n(&out->ring->magic, DUMMY_IFACE_RING_MAGIC,
+			__ATOMIC_RELEASE);
+
+	return 0;
+}
+
+static void di_event_ring_write(struct dummy_iface_ring *r,
+		const struct dummy_iface_event *ev)
+{
+	uint64_t head = r->head;
+	struct dummy_iface_ring_slot *slot = &r->slot[head & (r->capacity - 1)];
+
+	__atomic_store_n(&slot->seq, 2 * head + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	memcpy(&slot->ev, ev, sizeof(*ev));
+
+	__atomic_store_n(&slot->seq, 2 * (head + 1), __ATOMIC_RELEASE);
+	__atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+}
+
+void dummy_iface_event_emit(struct dummy_iface_event_out *out,
+		const struct dummy_iface_link *link)
+{
+	struct dummy_iface_event ev;
+
+	ev.len = sizeof(ev);
+	ev.version = DUMMY_IFACE_EVENT_VERSION;
+	memcpy(&ev.link, link, sizeof(ev.link));
+
+	if (out->ring)
+		di_event_ring_write(out->ring, &ev);
+	else if (out->stream)
+		fwrite(&ev, sizeof(ev), 1, out->stream);
+}
+
+void dummy_iface_event_flush(struct dummy_iface_event_out *out)
+{
+	if (out->stream)
+		fflush(out->stream);
+}
+
+void dummy_iface_event_close(struct dummy_iface_event_out *out)
+{
+	if (out->stream && out->stream != stdout)
+		fclose(out->stream);
+	else if (out->stream)
+		fflush(out->stream);
+
+	if (out->ring)
+		munmap(out->ring, out->ring_size);
+
+	memset(out, 0, sizeof(*out));
+}
@@ -0,0 +1,110 @@
+/*
+ * dummy_iface_event.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsiv
+ *
+ * Binary link events written by the listener in non-verbose mode, either
+ * as a stream of length-prefixed records or into a shared memory ring.
+ * Records are in host byte order and only meant for consumers on the
+ * same machine.
+ */
+
+#ifndef SRC_USER_SPACE_DUMMY_IFACE_EVENT_H_
+#define SRC_USER_SPACE_DUMMY_IFACE_EVENT_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "dummy_iface_link.h"
+
+#define DUMMY_IFACE_EVENT_VERSION	2
+
+/* Fixed size, @len is sizeof(struct dummy_iface_event) and lets a stream
+ * reader skip records of a version it does not know.
+ */
+struct dummy_iface_event {
+	uint32_t len;
+	uint32_t version;
+	struct dummy_iface_link link;
+};
+
+/*
+ * Shared memory ring, a single writer and any number of readers. The
+ * writer never waits: a reader that falls more than @capacity records
+ * behind loses the oldest ones. Each slot carries a sequence number that
+ * is odd while the slot is written and 2 * (index + 1) once it is done.
+ */
+#define DUMMY_IFACE_RING_MAGIC		0x64697267	/* "dirg" */
+#define DUMMY_IFACE_RING_CAPACITY	65536
+
+struct dummy_iface_ring_slot {
+	uint64_t seq;
+	struct dummy_iface_event ev;
+};
+
+struct dummy_iface_ring {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t slot_size;
+	uint32_t capacity;		/* power of 2 */
+	uint64_t head;			/* index of the next record written */
+	uint8_t pad[40];
+	struct dummy_iface_ring_slot slot[];
+};
+
+/* Read the record at *@pos. Returns 1 and advances *@pos if one was read,
+ * 0 if there is none yet, -1 if the reader was overtaken, *@pos is then
+ * moved to the oldest record still in the ring.
+ */
+static inline int dummy_iface_ring_read(const struct dummy_iface_ring *r,
+		uint64_t *pos, struct dummy_iface_event *ev)
+{
+	const struct dummy_iface_ring_slot *slot;
+	uint64_t head, seq;
+
+	head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+	if (*pos == head)
+		return 0;
+	if (head - *pos > r->capacity)
+		goto lapped;
+
+	slot = &r->slot[*pos & (r->capacity - 1)];
+	seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+	if (seq != 2 * (*pos + 1))
+		goto lapped;
+
+	memcpy(ev, &slot->ev, sizeof(*ev));
+
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq)
+		goto lapped;
+
+	(*pos)++;
+	return 1;
+
+lapped:
+	head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+	*pos = head - r->capacity;
+	if (head < r->capacity)
+		*pos = 0;
+	return -1;
+}
+
+struct dummy_iface_event_out {
+	FILE *stream;
+	struct dummy_iface_ring *ring;
+	size_t ring_size;
+};
+
+int dummy_iface_event_stream_open(struct dummy_iface_event_out *out,
+		const char *path);
+int dummy_iface_event_ring_open(struct dummy_iface_event_out *out,
+		const char *name, uint32_t capacity);
+void dummy_iface_event_emit(struct dummy_iface_event_out *out,
+		const struct dummy_iface_link *link);
+void dummy_iface_event_flush(struct dummy_iface_event_out *out);
+void dummy_iface_event_close(struct dummy_iface_event_out *out);
+
+#endif /* SRC_USER_SPACE_DUMMY_IFACE_EVENT_H_ */
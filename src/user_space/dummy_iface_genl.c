@@ -0,0 +1,207 @@
+/*
+ * dummy_iface_genl.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsiv
+ *
+ * Only libnl core is required by the tools, so the controller is queried
+ * by hand instead of with genl_ctrl_resolve() of libnl-genl.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <linux/genetlink.h>
+
+#include <libnl3/netlink/msg.h>
+#include <libnl3/netlink/attr.h>
+#include <libnl3/netlink/errno.h>
+
+#include "dummy_iface_genl.h"
+#include "dummy_iface_nla.h"
+
+static int di_genl_find_group(struct nlattr *groups, int *group)
+{
+	int rem, rem_grp;
+	struct nlattr *grp, *nla;
+
+	di_nla_for_each_nested(grp, groups, rem) {
+		int id = -1;
+		bool match = false;
+
+		di_nla_for_each_nested(nla, grp, rem_grp) {
+			switch (di_nla_type(nla)) {
+			case CTRL_ATTR_MCAST_GRP_ID:
+				id = *(uint32_t *)di_nla_data(nla);
+				break;
+			case CTRL_ATTR_MCAST_GRP_NAME:
+				match = !strncmp(di_nla_data(nla),
+						DUMMY_IFACE_GENL_MCGRP,
+						di_nla_len(nla));
+				break;
+			}
+		}
+
+		if (match && id >= 0) {
+			*group = id;
+			return 0;
+		}
+	}
+
+	return -NLE_OBJ_NOTFOUND;
+}
+
+/* Send @msg, whose reply is all we read: no ACK to trail behind it */
+static int di_genl_request(struct nl_sock *sk, struct nl_msg *msg)
+{
+	nl_complete_msg(sk, msg);
+	nlmsg_hdr(msg)->nlmsg_flags &= ~NLM_F_ACK;
+
+	return nl_send(sk, msg);
+}
+
+int dummy_iface_genl_resolve(struct nl_sock *sk, int *family, int *group)
+{
+	struct genlmsghdr ghdr = {
+		.cmd		= CTRL_CMD_GETFAMILY,
+		.version	= 1,
+	};
+	struct sockaddr_nl peer;
+	struct nlmsghdr *hdr;
+	struct nl_msg *msg;
+	struct nlattr *nla;
+	unsigned char *buf = NULL;
+	int n, rem, err;
+
+	*family = *group = -1;
+
+	msg = nlmsg_alloc_simple(GENL_ID_CTRL, NLM_F_REQUEST);
+	if (!msg)
+		return -NLE_NOMEM;
+
+	err = nlmsg_append(msg, &ghdr, sizeof(ghdr), NLMSG_ALIGNTO);
+	if (!err)
+		err = nla_put_string(msg, CTRL_ATTR_FAMILY_NAME,
+				DUMMY_IFACE_GENL_NAME);
+	if (!err)
+		err = di_genl_request(sk, msg);
+	nlmsg_free(msg);
+	if (err < 0)
+		return err;
+
+	n = nl_recv(sk, &peer, &buf, NULL);
+	if (n <= 0)
+		return n ? n : -NLE_NODEV;
+
+	err = -NLE_OBJ_NOTFOUND;
+	hdr = (struct nlmsghdr *)buf;
+	for (; nlmsg_ok(hdr, n); hdr = nlmsg_next(hdr, &n)) {
+		if (hdr->nlmsg_type == NLMSG_ERROR) {
+			struct nlmsgerr *e = nlmsg_data(hdr);
+
+			/* ENOENT: the module is not loaded */
+			if (e->error) {
+				err = -nl_syserr2nlerr(-e->error);
+				break;
+			}
+			continue;
+		}
+		if (hdr->nlmsg_type != GENL_ID_CTRL)
+			continue;
+
+		di_nlmsg_for_each_attr(nla, hdr, GENL_HDRLEN, rem) {
+			switch (di_nla_type(nla)) {
+			case CTRL_ATTR_FAMILY_ID:
+				*family = *(uint16_t *)di_nla_data(nla);
+				break;
+			case CTRL_ATTR_MCAST_GROUPS:
+				di_genl_find_group(nla, group);
+				break;
+			}
+		}
+
+		if (*family >= 0 && *group >= 0)
+			err = 0;
+	}
+
+	free(buf);
+
+	return err;
+}
+
+static void di_genl_parse_stats(struct nlattr *nest,
+		uint64_t stats[DUMMY_IFACE_STATS_MAX + 1])
+{
+	struct nlattr *nla;
+	int rem;
+
+	di_nla_for_each_nested(nla, nest, rem) {
+		int type = di_nla_type(nla);
+
+		if (type > DUMMY_IFACE_STATS_MAX)
+			continue;
+		if (di_nla_len(nla) == sizeof(uint64_t))
+			memcpy(&stats[type], di_nla_data(nla), sizeof(uint64_t));
+		else if (di_nla_len(nla) == sizeof(uint32_t))
+			stats[type] = *(uint32_t *)di_nla_data(nla);
+	}
+}
+
+int dummy_iface_genl_get_stats(struct nl_sock *sk, int family,
+		uint64_t stats[DUMMY_IFACE_STATS_MAX + 1])
+{
+	struct genlmsghdr ghdr = {
+		.cmd		= DUMMY_IFACE_CMD_GETSTATS,
+		.version	= DUMMY_IFACE_GENL_VERSION,
+	};
+	struct sockaddr_nl peer;
+	struct nlmsghdr *hdr;
+	struct nl_msg *msg;
+	struct nlattr *nla;
+	unsigned char *buf = NULL;
+	int n, rem, err;
+
+	memset(stats, 0, sizeof(*stats) * (DUMMY_IFACE_STATS_MAX + 1));
+
+	msg = nlmsg_alloc_simple(family, NLM_F_REQUEST);
+	if (!msg)
+		return -NLE_NOMEM;
+
+	err = nlmsg_append(msg, &ghdr, sizeof(ghdr), NLMSG_ALIGNTO);
+	if (!err)
+		err = di_genl_request(sk, msg);
+	nlmsg_free(msg);
+	if (err < 0)
+		return err;
+
+	n = nl_recv(sk, &peer, &buf, NULL);
+	if (n <= 0)
+		return n ? n : -NLE_NODEV;
+
+	err = -NLE_OBJ_NOTFOUND;
+	hdr = (struct nlmsghdr *)buf;
+	for (; nlmsg_ok(hdr, n); hdr = nlmsg_next(hdr, &n)) {
+		if (hdr->nlmsg_type == NLMSG_ERROR) {
+			struct nlmsgerr *e = nlmsg_data(hdr);
+
+			if (e->error) {
+				err = -nl_syserr2nlerr(-e->error);
+				break;
+			}
+			continue;
+		}
+		if (hdr->nlmsg_type != family)
+			continue;
+
+		di_nlmsg_for_each_attr(nla, hdr, GENL_HDRLEN, rem)
+			if (di_nla_type(nla) == DUMMY_IFACE_A_STATS)
+				di_genl_parse_stats(nla, stats);
+		err = 0;
+	}
+
+	free(buf);
+
+	return err;
+}
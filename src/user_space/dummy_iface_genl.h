@@ -0,0 +1,27 @@
+/*
+ * dummy_iface_genl.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsiv
+ */
+
+#ifndef SRC_USER_SPACE_DUMMY_IFACE_GENL_H_
+#define SRC_USER_SPACE_DUMMY_IFACE_GENL_H_
+
+#include <libnl3/netlink/netlink.h>
+#include <libnl3/netlink/socket.h>
+
+#include "../kernel_space/dummy_iface_uapi.h"
+
+/* Look the dummy_iface family and its event group up with the generic
+ * netlink controller, @sk is a NETLINK_GENERIC socket.
+ */
+int dummy_iface_genl_resolve(struct nl_sock *sk, int *family, int *group);
+
+/* DUMMY_IFACE_CMD_GETSTATS for the namespace of @sk, @stats is indexed by
+ * DUMMY_IFACE_STATS_*.
+ */
+int dummy_iface_genl_get_stats(struct nl_sock *sk, int family,
+		uint64_t stats[DUMMY_IFACE_STATS_MAX + 1]);
+
+#endif /* SRC_USER_SPACE_DUMMY_IFACE_GENL_H_ */
@@ -0,0 +1,287 @@
+/*
+ * dummy_iface_link.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsiv
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <linux/rtnetlink.h>
+#include <linux/genetlink.h>
+
+#include <libnl3/netlink/netlink.h>
+#include <libnl3/netlink/msg.h>
+#include <libnl3/netlink/attr.h>
+#include <libnl3/netlink/errno.h>
+
+#include "dummy_iface_link.h"
+#include "dummy_iface_nla.h"
+#include "dummy_iface_attr.h"
+
+typedef int (*dummy_iface_nla_cb)(int attr, struct nlattr *nla, void *context);
+
+/* @minlen: shorter attributes are not passed to @cb */
+struct dummy_iface_nla_handler {
+	dummy_iface_nla_cb cb;
+	int minlen;
+};
+
+static int di_ifla_ifname_handler(int attr, struct nlattr *nla, void *context);
+static int di_ifla_address_handler(int attr, struct nlattr *nla, void *context);
+static int di_ifla_mtu_handler(int attr, struct nlattr *nla, void *context);
+static int di_ifla_link_handler(int attr, struct nlattr *nla, void *context);
+static int di_ifla_linkinfo_handler(int attr, struct nlattr *nla, void *context);
+
+static int di_ifla_info_kind_handler(int attr, struct nlattr *nla, void *context);
+static int di_ifla_info_data_handler(int attr, struct nlattr *nla, void *context);
+
+static const struct dummy_iface_nla_handler ifla_nla_handler[IFLA_MAX+1] = {
+	[IFLA_IFNAME]		= { .cb = di_ifla_ifname_handler },
+	[IFLA_ADDRESS]		= { .cb = di_ifla_address_handler },
+	[IFLA_MTU]		= { .cb = di_ifla_mtu_handler, .minlen = sizeof(uint32_t) },
+	[IFLA_LINK]		= { .cb = di_ifla_link_handler, .minlen = sizeof(uint32_t) },
+	[IFLA_LINKINFO]		= { .cb = di_ifla_linkinfo_handler },
+};
+
+static const struct dummy_iface_nla_handler ifla_info_nla_handler[IFLA_INFO_MAX+1] = {
+	[IFLA_INFO_KIND]	= { .cb = di_ifla_info_kind_handler },
+	[IFLA_INFO_DATA]	= { .cb = di_ifla_info_data_handler },
+};
+
+/*
+ * Bitmap of the IFLA_* attributes that have a handler, built at compile
+ * time. A message is walked once and everything else (stats, AF_SPEC,
+ * ...: most of the bytes of an RTM_NEWLINK) is skipped on a single test.
+ */
+#define DI_IFLA_WORDS		2
+#define DI_IFLA_BIT(_attr, _word)					\
+	((_attr) / 64 == (_word) ? 1ULL << ((_attr) % 64) : 0)
+#define DI_IFLA_WORD(_word)						\
+	(DI_IFLA_BIT(IFLA_IFNAME, _word) |				\
+	 DI_IFLA_BIT(IFLA_ADDRESS, _word) |				\
+	 DI_IFLA_BIT(IFLA_MTU, _word) |					\
+	 DI_IFLA_BIT(IFLA_LINK, _word) |				\
+	 DI_IFLA_BIT(IFLA_LINKINFO, _word))
+
+static const uint64_t di_ifla_wanted[DI_IFLA_WORDS] = {
+	DI_IFLA_WORD(0),
+	DI_IFLA_WORD(1),
+};
+
+_Static_assert(IFLA_MAX < DI_IFLA_WORDS * 64, "grow DI_IFLA_WORDS");
+
+static inline int di_ifla_is_wanted(int attr)
+{
+	return attr <= IFLA_MAX &&
+		(di_ifla_wanted[attr / 64] >> (attr % 64)) & 1;
+}
+
+/* Hand a top level IFLA_* attribute to its handler */
+int dummy_iface_link_attr(struct dummy_iface_link *link, struct nlattr *nla)
+{
+	int attr = di_nla_type(nla);
+	const struct dummy_iface_nla_handler *h;
+
+	if (attr > IFLA_MAX || !ifla_nla_handler[attr].cb)
+		return 0;
+
+	h = &ifla_nla_handler[attr];
+	if (di_nla_len(nla) < h->minlen)
+		return -NLE_INVAL;
+
+	return h->cb(attr, nla, link);
+}
+
+/* Decode an RTM_*LINK message into @link in a single pass over its
+ * attributes. Returns 0 or a negative libnl error code.
+ */
+int dummy_iface_link_parse(struct nlmsghdr *hdr, struct dummy_iface_link *link)
+{
+	int rem, err = 0;
+	struct nlattr *nla;
+	struct ifinfomsg *ifi;
+
+	if (hdr->nlmsg_len < NLMSG_LENGTH(sizeof(*ifi)))
+		return -NLE_MSG_TOOSHORT;
+
+	ifi = NLMSG_DATA(hdr);
+	memset(link, 0, sizeof(*link));
+	link->type = hdr->nlmsg_type;
+	link->seq = hdr->nlmsg_seq;
+	link->ifindex = ifi->ifi_index;
+	link->ifi_flags = ifi->ifi_flags;
+
+	di_nlmsg_for_each_attr(nla, hdr, sizeof(*ifi), rem) {
+		if (!di_ifla_is_wanted(di_nla_type(nla)))
+			continue;
+
+		err = dummy_iface_link_attr(link, nla);
+		if (err)
+			break;
+	}
+
+	return err;
+}
+
+static int di_ifla_ifname_handler(int attr, struct nlattr *nla, void *context)
+{
+	struct dummy_iface_link *link = context;
+
+	di_nla_strlcpy(link->ifname, nla, sizeof(link->ifname));
+	link->present |= DI_LINK_IFNAME;
+
+	return 0;
+}
+
+static int di_ifla_address_handler(int attr, struct nlattr *nla, void *context)
+{
+	struct dummy_iface_link *link = context;
+	int len = di_nla_len(nla);
+
+	if (len > sizeof(link->addr))
+		len = sizeof(link->addr);
+
+	memcpy(link->addr, di_nla_data(nla), len);
+	link->addr_len = len;
+	link->present |= DI_LINK_ADDRESS;
+
+	return 0;
+}
+
+static int di_ifla_mtu_handler(int attr, struct nlattr *nla, void *context)
+{
+	struct dummy_iface_link *link = context;
+
+	link->mtu = *(uint32_t *)di_nla_data(nla);
+	link->present |= DI_LINK_MTU;
+
+	return 0;
+}
+
+static int di_ifla_link_handler(int attr, struct nlattr *nla, void *context)
+{
+	struct dummy_iface_link *link = context;
+
+	link->link = *(uint32_t *)di_nla_data(nla);
+	link->present |= DI_LINK_LINK;
+
+	return 0;
+}
+
+static int di_ifla_linkinfo_handler(int attr, struct nlattr *nla, void *context)
+{
+	int rem, err;
+	struct nlattr *nla_iter;
+
+	di_nla_for_each_nested(nla_iter, nla, rem) {
+		int attr = di_nla_type(nla_iter);
+		if (attr <= IFLA_INFO_MAX && ifla_info_nla_handler[attr].cb) {
+			err = ifla_info_nla_handler[attr].cb(attr, nla_iter,
+					context);
+			if (err)
+				return err;
+		}
+	}
+
+	return 0;
+}
+
+static int di_ifla_info_kind_handler(int attr, struct nlattr *nla, void *context)
+{
+	struct dummy_iface_link *link = context;
+
+	di_nla_strlcpy(link->kind, nla, sizeof(link->kind));
+	link->present |= DI_LINK_KIND;
+
+	return 0;
+}
+
+static int di_ifla_info_data_handler(int attr, struct nlattr *nla, void *context)
+{
+	int err;
+	struct dummy_iface_link *link = context;
+
+	/* Data of another kind of link */
+	if (strcmp(link->kind, DUMMY_IFACE_KIND))
+		return 0;
+
+	err = dummy_iface_params_parse(nla, &link->params,
+			&link->params_present);
+	if (err)
+		return err;
+
+	link->present |= DI_LINK_DATA;
+
+	return 0;
+}
+
+/* Decode an event or dump reply of the dummy_iface generic netlink
+ * family. DUMMY_IFACE_CMD_NEWLINK and _CHANGELINK are reported as
+ * RTM_NEWLINK, DUMMY_IFACE_CMD_DELLINK as RTM_DELLINK.
+ */
+int dummy_iface_link_parse_genl(struct nlmsghdr *hdr,
+		struct dummy_iface_link *link)
+{
+	int rem, err;
+	struct nlattr *nla;
+	struct genlmsghdr *ghdr;
+
+	if (hdr->nlmsg_len < NLMSG_LENGTH(GENL_HDRLEN))
+		return -NLE_MSG_TOOSHORT;
+
+	ghdr = NLMSG_DATA(hdr);
+	memset(link, 0, sizeof(*link));
+
+	switch (ghdr->cmd) {
+	case DUMMY_IFACE_CMD_NEWLINK:
+	case DUMMY_IFACE_CMD_CHANGELINK:
+		link->type = RTM_NEWLINK;
+		break;
+	case DUMMY_IFACE_CMD_DELLINK:
+		link->type = RTM_DELLINK;
+		break;
+	default:
+		return -NLE_MSGTYPE_NOSUPPORT;
+	}
+
+	link->seq = hdr->nlmsg_seq;
+	strcpy(link->kind, DUMMY_IFACE_KIND);
+	link->present |= DI_LINK_KIND;
+
+	di_nlmsg_for_each_attr(nla, hdr, GENL_HDRLEN, rem) {
+		/* Attributes we do not know are skipped, whatever their size */
+		switch (di_nla_type(nla)) {
+		case DUMMY_IFACE_A_IFINDEX:
+			if (di_nla_len(nla) < sizeof(uint32_t))
+				return -NLE_INVAL;
+			link->ifindex = *(uint32_t *)di_nla_data(nla);
+			break;
+		case DUMMY_IFACE_A_FLAGS:
+			if (di_nla_len(nla) < sizeof(uint32_t))
+				return -NLE_INVAL;
+			link->ifi_flags = *(uint32_t *)di_nla_data(nla);
+			break;
+		case DUMMY_IFACE_A_IFNAME:
+			di_ifla_ifname_handler(IFLA_IFNAME, nla, link);
+			break;
+		case DUMMY_IFACE_A_MTU:
+			if (di_nla_len(nla) < sizeof(uint32_t))
+				return -NLE_INVAL;
+			di_ifla_mtu_handler(IFLA_MTU, nla, link);
+			break;
+		case DUMMY_IFACE_A_ADDRESS:
+			di_ifla_address_handler(IFLA_ADDRESS, nla, link);
+			break;
+		case DUMMY_IFACE_A_DATA:
+			err = di_ifla_info_data_handler(IFLA_INFO_DATA, nla,
+					link);
+			if (err)
+				return err;
+			break;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * dummy_iface_link.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsiv
+ */
+
+#ifndef SRC_USER_SPACE_DUMMY_IFACE_LINK_H_
+#define SRC_USER_SPACE_DUMMY_IFACE_LINK_H_
+
+#include <stdint.h>
+
+#include <linux/netlink.h>
+#include <linux/if_link.h>
+
+#include "../kernel_space/dummy_iface_uapi.h"
+
+#define DI_IFNAMSIZ	16
+#define DI_ADDR_LEN	32	/* MAX_ADDR_LEN */
+#define DI_KINDSIZ	16
+#define DI_QUEUE_CPUS	64
+
+/* IFLA_DUMMY_IFACE_QUEUE_CPUS: @nr CPUs, the first DI_QUEUE_CPUS kept */
+struct dummy_iface_cpus {
+	uint32_t nr;
+	int32_t cpu[DI_QUEUE_CPUS];
+};
+
+/* Values of the IFLA_DUMMY_IFACE_* attributes of a link */
+struct dummy_iface_params {
+	uint8_t attr0;
+	uint16_t attr1;
+	uint32_t attr2;
+	uint32_t attr_nest_a;
+	uint32_t attr_nest_b;
+	struct ifla_dummy_iface_bin_attr attr_bin;
+	uint8_t mode;
+	uint32_t drop;
+	uint32_t delay;
+	uint32_t jitter;
+	uint64_t rate;
+	uint32_t burst;
+	uint32_t gen_rate;
+	uint16_t gen_len;
+	struct dummy_iface_cpus queue_cpus;
+};
+
+/* dummy_iface_link.present bits */
+#define DI_LINK_IFNAME		(1 << 0)
+#define DI_LINK_ADDRESS		(1 << 1)
+#define DI_LINK_MTU		(1 << 2)
+#define DI_LINK_LINK		(1 << 3)
+#define DI_LINK_KIND		(1 << 4)
+#define DI_LINK_DATA		(1 << 5)
+
+/* An RTM_NEWLINK/RTM_DELLINK message, decoded. Only what the present bits
+ * (and params_present, one bit per IFLA_DUMMY_IFACE_* attribute) tell is
+ * valid, the rest is zero.
+ */
+struct dummy_iface_link {
+	uint16_t type;
+	uint16_t addr_len;
+	uint32_t seq;
+	int32_t ifindex;
+	uint32_t ifi_flags;
+	uint32_t present;
+	uint32_t mtu;
+	uint32_t link;
+	char ifname[DI_IFNAMSIZ];
+	char kind[DI_KINDSIZ];
+	uint8_t addr[DI_ADDR_LEN];
+	uint64_t params_present;
+	struct dummy_iface_params params;
+};
+
+struct nlattr;
+
+int dummy_iface_link_parse(struct nlmsghdr *hdr, struct dummy_iface_link *link);
+int dummy_iface_link_attr(struct dummy_iface_link *link, struct nlattr *nla);
+int dummy_iface_link_parse_genl(struct nlmsghdr *hdr,
+		struct dummy_iface_link *link);
+
+#endif /* SRC_USER_SPACE_DUMMY_IFACE_LINK_H_ */
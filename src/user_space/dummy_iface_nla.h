@@ -0,0 +1,79 @@
+/*
+ * dummy_iface_nla.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsiv
+ *
+ * Inline attribute accessors for the decode paths. The libnl ones are
+ * out of line library calls, which is most of the cost of walking an
+ * RTM_NEWLINK that carries a couple of dozen attributes.
+ */
+
+#ifndef SRC_USER_SPACE_DUMMY_IFACE_NLA_H_
+#define SRC_USER_SPACE_DUMMY_IFACE_NLA_H_
+
+#include <string.h>
+
+#include <linux/netlink.h>
+
+static inline int di_nla_type(const struct nlattr *nla)
+{
+	return nla->nla_type & NLA_TYPE_MASK;
+}
+
+static inline int di_nla_len(const struct nlattr *nla)
+{
+	return nla->nla_len - NLA_HDRLEN;
+}
+
+static inline void *di_nla_data(const struct nlattr *nla)
+{
+	return (char *)nla + NLA_HDRLEN;
+}
+
+static inline int di_nla_ok(const struct nlattr *nla, int rem)
+{
+	return rem >= (int)sizeof(*nla) &&
+		nla->nla_len >= sizeof(*nla) &&
+		nla->nla_len <= rem;
+}
+
+static inline struct nlattr *di_nla_next(const struct nlattr *nla, int *rem)
+{
+	int len = NLA_ALIGN(nla->nla_len);
+
+	*rem -= len;
+	return (struct nlattr *)((char *)nla + len);
+}
+
+#define di_nla_for_each(pos, head, len, rem)				\
+	for (pos = (head), rem = (len); di_nla_ok(pos, rem);		\
+	     pos = di_nla_next(pos, &(rem)))
+
+#define di_nla_for_each_nested(pos, nla, rem)				\
+	di_nla_for_each(pos, (struct nlattr *)di_nla_data(nla),	\
+			di_nla_len(nla), rem)
+
+/* Attributes of a message with a @hdrlen bytes family header */
+#define di_nlmsg_for_each_attr(pos, nlh, hdrlen, rem)			\
+	di_nla_for_each(pos,						\
+		(struct nlattr *)((char *)NLMSG_DATA(nlh) + NLMSG_ALIGN(hdrlen)), \
+		(nlh)->nlmsg_len - NLMSG_LENGTH(NLMSG_ALIGN(hdrlen)), rem)
+
+/* strlcpy() of a string attribute */
+static inline void di_nla_strlcpy(char *dst, const struct nlattr *nla,
+		size_t size)
+{
+	size_t len = di_nla_len(nla);
+	const char *src = di_nla_data(nla);
+
+	if (len && src[len - 1] == '\0')
+		len--;
+	if (len >= size)
+		len = size - 1;
+
+	memcpy(dst, src, len);
+	dst[len] = '\0';
+}
+
+#endif /* SRC_USER_SPACE_DUMMY_IFACE_NLA_H_ */
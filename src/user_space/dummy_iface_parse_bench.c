@@ -0,0 +1,223 @@
+/*
+ * dummy_iface_parse_bench.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsiv
+ *
+ * Per message decode cost of an RTM_NEWLINK the way the kernel sends it
+ * for a dummy_iface link: nlmsg_parse() into a full IFLA_MAX table then
+ * a scan of the handled attributes (what the listener did) against the
+ * single pass of dummy_iface_link_parse().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <linux/if_link.h>
+#include <linux/netdevice.h>
+#include <linux/rtnetlink.h>
+
+#include <libnl3/netlink/netlink.h>
+#include <libnl3/netlink/msg.h>
+#include <libnl3/netlink/attr.h>
+
+#include "dummy_iface_macro.h"
+#include "dummy_iface_link.h"
+
+#define DI_BENCH_ITERATIONS	2000000
+
+static struct nla_policy ifla_policy[IFLA_MAX+1] = {
+	[IFLA_IFNAME]		= { .type = NLA_STRING, .maxlen = IFNAMSIZ-1 },
+	[IFLA_ADDRESS]		= {  .maxlen = MAX_ADDR_LEN },
+	[IFLA_BROADCAST]	= {  .maxlen = MAX_ADDR_LEN },
+	[IFLA_MAP]		= {  .maxlen = sizeof(struct rtnl_link_ifmap) },
+	[IFLA_MTU]		= { .type = NLA_U32 },
+	[IFLA_LINK]		= { .type = NLA_U32 },
+	[IFLA_MASTER]		= { .type = NLA_U32 },
+	[IFLA_CARRIER]		= { .type = NLA_U8 },
+	[IFLA_TXQLEN]		= { .type = NLA_U32 },
+	[IFLA_WEIGHT]		= { .type = NLA_U32 },
+	[IFLA_OPERSTATE]	= { .type = NLA_U8 },
+	[IFLA_LINKMODE]		= { .type = NLA_U8 },
+	[IFLA_LINKINFO]		= { .type = NLA_NESTED },
+	[IFLA_NET_NS_PID]	= { .type = NLA_U32 },
+	[IFLA_NET_NS_FD]	= { .type = NLA_U32 },
+	[IFLA_IFALIAS]		= { .type = NLA_STRING, .maxlen = IFALIASZ-1 },
+	[IFLA_VFINFO_LIST]	= {. type = NLA_NESTED },
+	[IFLA_VF_PORTS]		= { .type = NLA_NESTED },
+	[IFLA_PORT_SELF]	= { .type = NLA_NESTED },
+	[IFLA_AF_SPEC]		= { .type = NLA_NESTED },
+	[IFLA_EXT_MASK]		= { .type = NLA_U32 },
+	[IFLA_PROMISCUITY]	= { .type = NLA_U32 },
+	[IFLA_NUM_TX_QUEUES]	= { .type = NLA_U32 },
+	[IFLA_NUM_RX_QUEUES]	= { .type = NLA_U32 },
+	[IFLA_PHYS_PORT_ID]	= { .maxlen = MAX_ADDR_LEN },
+	[IFLA_CARRIER_CHANGES]	= { .type = NLA_U32 },  /* ignored */
+};
+
+/* The attributes rtnl_fill_ifinfo() puts in a notification, with the
+ * sizes they have on a 4.x kernel.
+ */
+static struct nl_msg *di_bench_msg(void)
+{
+	struct nl_msg *msg;
+	struct nlattr *nest, *af;
+	struct ifinfomsg ifi = { .ifi_family = AF_UNSPEC, .ifi_index = 42 };
+	struct rtnl_link_stats64 stats64 = { 0 };
+	struct rtnl_link_stats stats = { 0 };
+	struct rtnl_link_ifmap map = { 0 };
+	uint8_t addr[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x2a };
+	uint8_t bcast[6] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+	uint8_t blob[304] = { 0 };
+
+	msg = nlmsg_alloc_simple(RTM_NEWLINK, 0);
+	if (!msg || nlmsg_append(msg, &ifi, sizeof(ifi), NLMSG_ALIGNTO))
+		return NULL;
+
+	nla_put_string(msg, IFLA_IFNAME, "di4242");
+	nla_put_u32(msg, IFLA_TXQLEN, 1000);
+	nla_put_u8(msg, IFLA_OPERSTATE, 6);
+	nla_put_u8(msg, IFLA_LINKMODE, 0);
+	nla_put_u32(msg, IFLA_MTU, 1500);
+	nla_put_u32(msg, IFLA_GROUP, 0);
+	nla_put_u32(msg, IFLA_PROMISCUITY, 0);
+	nla_put_u32(msg, IFLA_NUM_TX_QUEUES, 8);
+	nla_put_u32(msg, IFLA_GSO_MAX_SEGS, 65535);
+	nla_put_u32(msg, IFLA_GSO_MAX_SIZE, 65536);
+	nla_put_u32(msg, IFLA_NUM_RX_QUEUES, 1);
+	nla_put_u8(msg, IFLA_CARRIER, 1);
+	nla_put_string(msg, IFLA_QDISC, "noqueue");
+	nla_put_u32(msg, IFLA_CARRIER_CHANGES, 0);
+	nla_put_u8(msg, IFLA_PROTO_DOWN, 0);
+	nla_put(msg, IFLA_MAP, sizeof(map), &map);
+	nla_put(msg, IFLA_ADDRESS, sizeof(addr), addr);
+	nla_put(msg, IFLA_BROADCAST, sizeof(bcast), bcast);
+	nla_put(msg, IFLA_STATS64, sizeof(stats64), &stats64);
+	nla_put(msg, IFLA_STATS, sizeof(stats), &stats);
+
+	nest = nla_nest_start(msg, IFLA_XDP);
+	nla_put_u8(msg, IFLA_XDP_ATTACHED, 0);
+	nla_nest_end(msg, nest);
+
+	nest = nla_nest_start(msg, IFLA_LINKINFO);
+	nla_put_string(msg, IFLA_INFO_KIND, "dummy_iface");
+	af = nla_nest_start(msg, IFLA_INFO_DATA);
+	nla_put_u8(msg, IFLA_DUMMY_IFACE_ATTR_0, 1);
+	nla_put_u16(msg, IFLA_DUMMY_IFACE_ATTR_1, 2);
+	nla_put_u32(msg, IFLA_DUMMY_IFACE_ATTR_2, 3);
+	nla_put(msg, IFLA_DUMMY_IFACE_ATTR_BIN,
+		sizeof(struct ifla_dummy_iface_bin_attr), blob);
+	nla_put_u8(msg, IFLA_DUMMY_IFACE_MODE, DUMMY_IFACE_MODE_SINK);
+	nla_nest_end(msg, af);
+	nla_nest_end(msg, nest);
+
+	nest = nla_nest_start(msg, IFLA_AF_SPEC);
+	af = nla_nest_start(msg, AF_INET);
+	nla_put(msg, IFLA_INET_CONF, 124, blob);
+	nla_nest_end(msg, af);
+	af = nla_nest_start(msg, AF_INET6);
+	nla_put_u32(msg, IFLA_INET6_FLAGS, 0);
+	nla_put(msg, IFLA_INET6_CACHEINFO, 16, blob);
+	nla_put(msg, IFLA_INET6_CONF, 200, blob);
+	nla_put(msg, IFLA_INET6_STATS, 304, blob);
+	nla_put(msg, IFLA_INET6_ICMP6STATS, 48, blob);
+	nla_put(msg, IFLA_INET6_TOKEN, 16, blob);
+	nla_put_u8(msg, IFLA_INET6_ADDR_GEN_MODE, 0);
+	nla_nest_end(msg, af);
+	nla_nest_end(msg, nest);
+
+	return msg;
+}
+
+/* What the listener did before: parse into a table, then scan it */
+static int di_parse_table(struct nlmsghdr *hdr, struct dummy_iface_link *link)
+{
+	int i, err;
+	struct ifinfomsg *ifi;
+	struct nlattr *ifla_tb[IFLA_MAX+1];
+	int ifla_attrs_to_parse[] = { IFLA_IFNAME, IFLA_ADDRESS, IFLA_MTU,
+			IFLA_LINK, IFLA_LINKINFO };
+
+	err = nlmsg_parse(hdr, sizeof(*ifi), ifla_tb, IFLA_MAX, ifla_policy);
+	if (err)
+		return err;
+
+	ifi = nlmsg_data(hdr);
+	memset(link, 0, sizeof(*link));
+	link->type = hdr->nlmsg_type;
+	link->seq = hdr->nlmsg_seq;
+	link->ifindex = ifi->ifi_index;
+	link->ifi_flags = ifi->ifi_flags;
+
+	for (i = 0; i < ARRAY_SIZE(ifla_attrs_to_parse); ++i) {
+		int attr = ifla_attrs_to_parse[i];
+		if (ifla_tb[attr])
+			dummy_iface_link_attr(link, ifla_tb[attr]);
+	}
+
+	return 0;
+}
+
+static double di_bench(const char *name,
+		int (*parse)(struct nlmsghdr *, struct dummy_iface_link *),
+		struct nlmsghdr *hdr, long iterations)
+{
+	struct dummy_iface_link link;
+	struct timespec start, end;
+	volatile uint32_t sink = 0;
+	double ns;
+	long i;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < iterations; ++i) {
+		if (parse(hdr, &link)) {
+			fprintf(stderr, "%s: parse failed\n", name);
+			return -1;
+		}
+		sink += link.mtu + link.params.attr2;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	ns = ((end.tv_sec - start.tv_sec) * 1e9 +
+		(end.tv_nsec - start.tv_nsec)) / iterations;
+	printf("%-12s %8.1f ns/msg\n", name, ns);
+
+	return ns;
+}
+
+int main(int argc, char *argv[])
+{
+	long iterations = DI_BENCH_ITERATIONS;
+	struct nlmsghdr *hdr;
+	struct nl_msg *msg;
+	double before, after;
+
+	if (argc > 1)
+		iterations = atol(argv[1]);
+	if (iterations <= 0) {
+		fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+		return 1;
+	}
+
+	msg = di_bench_msg();
+	if (!msg) {
+		fprintf(stderr, "Failed to build message\n");
+		return 1;
+	}
+	hdr = nlmsg_hdr(msg);
+
+	printf("RTM_NEWLINK of %u bytes, %ld iterations\n",
+			hdr->nlmsg_len, iterations);
+
+	before = di_bench("table+scan", di_parse_table, hdr, iterations);
+	after = di_bench("single-pass", dummy_iface_link_parse, hdr, iterations);
+	if (before > 0 && after > 0)
+		printf("speedup      %8.2fx\n", before / after);
+
+	nlmsg_free(msg);
+
+	return 0;
+}
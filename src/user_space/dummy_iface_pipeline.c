@@ -0,0 +1,474 @@
+/*
+ * dummy_iface_pipeline.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsiv
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+
+#include "dummy_iface_pipeline.h"
+
+#define DI_CACHELINE	64
+
+/* Records of a ring, 8 byte aligned. A PAD fills the end of the buffer
+ * when the next record does not fit there.
+ */
+enum {
+	DI_REC_PAD,
+	DI_REC_MSG,
+	DI_REC_MARK,
+};
+
+struct di_rec {
+	uint32_t len;		/* of data */
+	uint32_t type;
+	char data[];
+};
+
+/* What the receive thread hands to a worker */
+struct di_msg_ref {
+	struct dummy_iface_buf *buf;
+	struct nlmsghdr *hdr;
+};
+
+/* What a worker hands to the delivery thread */
+struct di_out {
+	struct nlmsghdr hdr;
+	struct dummy_iface_link link;
+};
+
+/*
+ * Single producer, single consumer ring of variable sized records. Each
+ * side only writes its own index, on its own cache line: the producer
+ * publishes a record by moving head past it, the consumer frees it by
+ * moving tail.
+ */
+struct di_spsc {
+	uint64_t head __attribute__((aligned(DI_CACHELINE)));
+	uint64_t next;		/* producer: head once the record is in */
+	uint64_t tail __attribute__((aligned(DI_CACHELINE)));
+	uint64_t size __attribute__((aligned(DI_CACHELINE)));	/* power of 2 */
+	char *buf;
+};
+
+/* A thread sleeping on an eventfd when its ring is empty. Producers
+ * only pay for the write() when it actually sleeps.
+ */
+struct di_waiter {
+	int efd;
+	int waiting;
+};
+
+struct di_worker {
+	struct dummy_iface_pipeline *p;
+	pthread_t thread;
+	struct di_spsc in;	/* from the receive thread */
+	struct di_spsc out;	/* to the delivery thread */
+	struct di_waiter wait;
+};
+
+struct dummy_iface_pipeline {
+	const struct dummy_iface_pipeline_ops *ops;
+	void *arg;
+	unsigned int nr_workers;
+	int stop;		/* workers: exit once drained */
+	int done;		/* delivery thread: likewise */
+	unsigned long stalls;
+	pthread_t thread;	/* delivery */
+	struct di_waiter wait;
+	struct di_worker workers[];
+};
+
+static uint32_t di_rec_size(uint32_t len)
+{
+	return (sizeof(struct di_rec) + len + 7) & ~7u;
+}
+
+static int di_spsc_init(struct di_spsc *r, uint64_t size)
+{
+	memset(r, 0, sizeof(*r));
+	r->size = size;
+	r->buf = malloc(size);
+
+	return r->buf ? 0 : -1;
+}
+
+/* Room for a record of @len bytes, NULL while the ring is too full */
+static struct di_rec *di_spsc_reserve(struct di_spsc *r, uint32_t len)
+{
+	uint64_t head = r->head, tail, off, contig;
+	uint32_t need = di_rec_size(len);
+	struct di_rec *rec;
+
+	tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+	off = head & (r->size - 1);
+	contig = r->size - off;
+
+	if (head + (need > contig ? contig + need : need) - tail > r->size)
+		return NULL;
+
+	if (need > contig) {
+		rec = (struct di_rec *)(r->buf + off);
+		rec->type = DI_REC_PAD;
+		rec->len = contig - sizeof(*rec);
+		head += contig;
+		off = 0;
+	}
+
+	rec = (struct di_rec *)(r->buf + off);
+	rec->len = len;
+	r->next = head + need;
+
+	return rec;
+}
+
+static void di_spsc_commit(struct di_spsc *r, struct di_rec *rec,
+		uint32_t type)
+{
+	rec->type = type;
+	__atomic_store_n(&r->head, r->next, __ATOMIC_RELEASE);
+}
+
+static struct di_rec *di_spsc_peek(struct di_spsc *r)
+{
+	uint64_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+	uint64_t tail = r->tail;
+	struct di_rec *rec;
+
+	while (tail != head) {
+		rec = (struct di_rec *)(r->buf + (tail & (r->size - 1)));
+		if (rec->type != DI_REC_PAD)
+			return rec;
+		tail += di_rec_size(rec->len);
+		__atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+	}
+
+	return NULL;
+}
+
+static void di_spsc_release(struct di_spsc *r, struct di_rec *rec)
+{
+	__atomic_store_n(&r->tail, r->tail + di_rec_size(rec->len),
+			__ATOMIC_RELEASE);
+}
+
+static bool di_spsc_empty(struct di_spsc *r)
+{
+	return __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) == r->tail;
+}
+
+static void di_wake(struct di_waiter *w)
+{
+	uint64_t one = 1;
+
+	/* Pairs with the fence in di_wait(): either the sleeper sees the
+	 * record or we see it waiting.
+	 */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_exchange_n(&w->waiting, 0, __ATOMIC_RELAXED))
+		if (write(w->efd, &one, sizeof(one)) < 0)
+			perror("Failed to wake pipeline thread");
+}
+
+static void di_wait(struct di_waiter *w, bool (*ready)(void *), void *arg,
+		int timeout)
+{
+	struct pollfd pfd = { .fd = w->efd, .events = POLLIN };
+	uint64_t cnt;
+
+	__atomic_store_n(&w->waiting, 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	if (!ready(arg) && poll(&pfd, 1, timeout) > 0)
+		if (read(w->efd, &cnt, sizeof(cnt)) < 0 && errno != EAGAIN)
+			perror("Failed to wait for pipeline work");
+
+	__atomic_store_n(&w->waiting, 0, __ATOMIC_RELAXED);
+}
+
+/* Producer side of a full ring: wake its consumer and let it run */
+static struct di_rec *di_reserve_wait(struct di_spsc *r, uint32_t len,
+		struct di_waiter *consumer, unsigned long *stalls)
+{
+	struct di_rec *rec;
+
+	while (!(rec = di_spsc_reserve(r, len))) {
+		if (stalls)
+			(*stalls)++;
+		stalls = NULL;
+		di_wake(consumer);
+		sched_yield();
+	}
+
+	return rec;
+}
+
+static bool di_worker_ready(void *arg)
+{
+	struct di_worker *w = arg;
+
+	return !di_spsc_empty(&w->in) ||
+		__atomic_load_n(&w->p->stop, __ATOMIC_ACQUIRE);
+}
+
+static void *di_worker_run(void *arg)
+{
+	struct di_worker *w = arg;
+	struct dummy_iface_pipeline *p = w->p;
+	struct di_rec *rec, *orec;
+	struct di_msg_ref *ref;
+	struct di_out *out;
+
+	while (true) {
+		rec = di_spsc_peek(&w->in);
+		if (!rec) {
+			if (__atomic_load_n(&p->stop, __ATOMIC_ACQUIRE) &&
+			    di_spsc_empty(&w->in))
+				break;
+			di_wait(&w->wait, di_worker_ready, w, -1);
+			continue;
+		}
+
+		if (rec->type == DI_REC_MARK) {
+			orec = di_reserve_wait(&w->out, rec->len, &p->wait, NULL);
+			memcpy(orec->data, rec->data, rec->len);
+			di_spsc_commit(&w->out, orec, DI_REC_MARK);
+			di_wake(&p->wait);
+		} else {
+			/* Decoded in place, straight into the record */
+			ref = (struct di_msg_ref *)rec->data;
+			orec = di_reserve_wait(&w->out, sizeof(*out), &p->wait,
+					NULL);
+			out = (struct di_out *)orec->data;
+			if (p->ops->decode(ref->hdr, &out->link, p->arg)) {
+				out->hdr = *ref->hdr;
+				di_spsc_commit(&w->out, orec, DI_REC_MSG);
+				di_wake(&p->wait);
+			}
+			dummy_iface_buf_put(ref->buf);
+		}
+
+		di_spsc_release(&w->in, rec);
+	}
+
+	return NULL;
+}
+
+/* Everything the workers have decoded, up to the next mark on each of
+ * them. The mark itself goes once all of them are at it: every message
+ * pushed before it has been delivered then.
+ */
+static bool di_deliver_some(struct dummy_iface_pipeline *p)
+{
+	struct di_rec *rec, *marks[DUMMY_IFACE_PIPELINE_WORKERS_MAX];
+	struct di_out *out;
+	bool progress = false;
+	unsigned int i, nr_marks = 0;
+
+	for (i = 0; i < p->nr_workers; ++i) {
+		struct di_spsc *r = &p->workers[i].out;
+
+		while ((rec = di_spsc_peek(r))) {
+			if (rec->type == DI_REC_MARK) {
+				marks[nr_marks++] = rec;
+				break;
+			}
+			out = (struct di_out *)rec->data;
+			p->ops->deliver(&out->hdr, &out->link, p->arg);
+			di_spsc_release(r, rec);
+			progress = true;
+		}
+	}
+
+	if (nr_marks < p->nr_workers)
+		return progress;
+
+	p->ops->mark(*(uint32_t *)marks[0]->data, p->arg);
+	for (i = 0; i < p->nr_workers; ++i)
+		di_spsc_release(&p->workers[i].out, marks[i]);
+
+	return true;
+}
+
+static bool di_delivery_ready(void *arg)
+{
+	struct dummy_iface_pipeline *p = arg;
+	unsigned int i;
+
+	for (i = 0; i < p->nr_workers; ++i)
+		if (!di_spsc_empty(&p->workers[i].out))
+			return true;
+
+	return __atomic_load_n(&p->done, __ATOMIC_ACQUIRE);
+}
+
+static void *di_delivery_run(void *arg)
+{
+	struct dummy_iface_pipeline *p = arg;
+	int timeout;
+
+	while (true) {
+		if (di_deliver_some(p))
+			continue;
+
+		if (__atomic_load_n(&p->done, __ATOMIC_ACQUIRE)) {
+			/* The workers are gone, take what they left */
+			while (di_deliver_some(p))
+				;
+			break;
+		}
+
+		timeout = p->ops->idle ? p->ops->idle(p->arg) : -1;
+		di_wait(&p->wait, di_delivery_ready, p, timeout);
+	}
+
+	return NULL;
+}
+
+static void di_pipeline_free(struct dummy_iface_pipeline *p)
+{
+	unsigned int i;
+
+	for (i = 0; i < p->nr_workers; ++i) {
+		free(p->workers[i].in.buf);
+		free(p->workers[i].out.buf);
+		if (p->workers[i].wait.efd >= 0)
+			close(p->workers[i].wait.efd);
+	}
+	if (p->wait.efd >= 0)
+		close(p->wait.efd);
+	free(p);
+}
+
+struct dummy_iface_pipeline *dummy_iface_pipeline_start(unsigned int workers,
+		const struct dummy_iface_pipeline_ops *ops, void *arg)
+{
+	struct dummy_iface_pipeline *p;
+	unsigned int i, started;
+	int err = 0;
+
+	if (!workers || workers > DUMMY_IFACE_PIPELINE_WORKERS_MAX) {
+		fprintf(stderr, "Workers must be 1 to %d\n",
+				DUMMY_IFACE_PIPELINE_WORKERS_MAX);
+		return NULL;
+	}
+
+	err = posix_memalign((void **)&p, DI_CACHELINE,
+			sizeof(*p) + workers * sizeof(p->workers[0]));
+	if (err) {
+		fprintf(stderr, "Failed to allocate pipeline\n");
+		return NULL;
+	}
+	memset(p, 0, sizeof(*p) + workers * sizeof(p->workers[0]));
+
+	p->ops = ops;
+	p->arg = arg;
+	p->nr_workers = workers;
+	p->wait.efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	err = p->wait.efd < 0;
+
+	for (i = 0; i < workers; ++i) {
+		struct di_worker *w = &p->workers[i];
+
+		w->p = p;
+		w->wait.efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+		err |= w->wait.efd < 0;
+		err |= di_spsc_init(&w->in, DUMMY_IFACE_PIPELINE_RING_SIZE);
+		err |= di_spsc_init(&w->out, DUMMY_IFACE_PIPELINE_RING_SIZE);
+	}
+	if (err) {
+		perror("Failed to set up pipeline");
+		di_pipeline_free(p);
+		return NULL;
+	}
+
+	for (started = 0; started < workers; ++started) {
+		err = pthread_create(&p->workers[started].thread, NULL,
+				di_worker_run, &p->workers[started]);
+		if (err)
+			break;
+	}
+	if (!err)
+		err = pthread_create(&p->thread, NULL, di_delivery_run, p);
+	if (err) {
+		fprintf(stderr, "Failed to start pipeline: %s\n",
+				strerror(err));
+		__atomic_store_n(&p->stop, 1, __ATOMIC_RELEASE);
+		for (i = 0; i < started; ++i) {
+			di_wake(&p->workers[i].wait);
+			pthread_join(p->workers[i].thread, NULL);
+		}
+		di_pipeline_free(p);
+		return NULL;
+	}
+
+	return p;
+}
+
+void dummy_iface_pipeline_stop(struct dummy_iface_pipeline *p)
+{
+	unsigned int i;
+
+	if (!p)
+		return;
+
+	__atomic_store_n(&p->stop, 1, __ATOMIC_RELEASE);
+	for (i = 0; i < p->nr_workers; ++i) {
+		di_wake(&p->workers[i].wait);
+		pthread_join(p->workers[i].thread, NULL);
+	}
+
+	__atomic_store_n(&p->done, 1, __ATOMIC_RELEASE);
+	di_wake(&p->wait);
+	pthread_join(p->thread, NULL);
+
+	di_pipeline_free(p);
+}
+
+void dummy_iface_pipeline_push(struct dummy_iface_pipeline *p,
+		struct dummy_iface_buf *buf, struct nlmsghdr *hdr,
+		int32_t ifindex)
+{
+	uint32_t shard = ((uint32_t)ifindex * 2654435761u) >> 16;
+	struct di_worker *w = &p->workers[shard % p->nr_workers];
+	struct di_msg_ref *ref;
+	struct di_rec *rec;
+
+	rec = di_reserve_wait(&w->in, sizeof(*ref), &w->wait, &p->stalls);
+	ref = (struct di_msg_ref *)rec->data;
+	ref->buf = buf;
+	ref->hdr = hdr;
+	dummy_iface_buf_hold(buf);
+	di_spsc_commit(&w->in, rec, DI_REC_MSG);
+	di_wake(&w->wait);
+}
+
+void dummy_iface_pipeline_mark(struct dummy_iface_pipeline *p, uint32_t mark)
+{
+	struct di_worker *w;
+	struct di_rec *rec;
+	unsigned int i;
+
+	for (i = 0; i < p->nr_workers; ++i) {
+		w = &p->workers[i];
+		rec = di_reserve_wait(&w->in, sizeof(mark), &w->wait,
+				&p->stalls);
+		memcpy(rec->data, &mark, sizeof(mark));
+		di_spsc_commit(&w->in, rec, DI_REC_MARK);
+		di_wake(&w->wait);
+	}
+}
+
+unsigned long dummy_iface_pipeline_stalls(const struct dummy_iface_pipeline *p)
+{
+	return p->stalls;
+}
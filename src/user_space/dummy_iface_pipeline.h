@@ -0,0 +1,64 @@
+/*
+ * dummy_iface_pipeline.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsiv
+ *
+ * Threaded pipeline of the listener. The receive thread hands each
+ * message, by reference to its receive buffer, to the SPSC ring of a
+ * decode worker chosen by ifindex so that the messages of a link stay
+ * in order, and goes back to the socket. Workers decode into their own
+ * SPSC ring towards a single delivery thread, the only one to touch the
+ * cache and the outputs.
+ * Marks pushed by the receive thread reach the delivery thread once
+ * every message pushed before them has been delivered.
+ */
+
+#ifndef SRC_USER_SPACE_DUMMY_IFACE_PIPELINE_H_
+#define SRC_USER_SPACE_DUMMY_IFACE_PIPELINE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <linux/netlink.h>
+
+#include "dummy_iface_link.h"
+#include "dummy_iface_bufpool.h"
+
+#define DUMMY_IFACE_PIPELINE_WORKERS_MAX	64
+/* Bytes of each ring, messages queued are bounded by the buffer pool */
+#define DUMMY_IFACE_PIPELINE_RING_SIZE		(4 * 1024 * 1024)
+
+struct dummy_iface_pipeline_ops {
+	/* Worker: decode @hdr into @link, false drops it */
+	bool (*decode)(struct nlmsghdr *hdr, struct dummy_iface_link *link,
+			void *arg);
+	/* Delivery thread: a decoded message, @hdr is its header only */
+	void (*deliver)(const struct nlmsghdr *hdr,
+			const struct dummy_iface_link *link, void *arg);
+	/* Delivery thread: a mark */
+	void (*mark)(uint32_t mark, void *arg);
+	/* Delivery thread, out of work: milliseconds until it must be
+	 * called again, -1 for no limit
+	 */
+	int (*idle)(void *arg);
+};
+
+struct dummy_iface_pipeline;
+
+struct dummy_iface_pipeline *dummy_iface_pipeline_start(unsigned int workers,
+		const struct dummy_iface_pipeline_ops *ops, void *arg);
+/* Flush what is queued and join the threads */
+void dummy_iface_pipeline_stop(struct dummy_iface_pipeline *p);
+
+/* Receive thread only. @hdr lies in @buf, which is held until the
+ * worker is done with it.
+ */
+void dummy_iface_pipeline_push(struct dummy_iface_pipeline *p,
+		struct dummy_iface_buf *buf, struct nlmsghdr *hdr,
+		int32_t ifindex);
+void dummy_iface_pipeline_mark(struct dummy_iface_pipeline *p, uint32_t mark);
+/* Times a full ring made the receive thread wait for a worker */
+unsigned long dummy_iface_pipeline_stalls(const struct dummy_iface_pipeline *p);
+
+#endif /* SRC_USER_SPACE_DUMMY_IFACE_PIPELINE_H_ */
@@ -1,8 +1,1155 @@
+/*
+ * dummy_iface_rtnl.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: oivantsiv
+ *
+ * Configuration client of the dummy_iface links: create, change and
+ * delete them, one command per line. The requests are pipelined: up to
+ * a window of them are in flight, sent DI_TX_BATCH per sendmmsg(), and
+ * their ACKs are matched by sequence number as they come back instead
+ * of waiting for each one in turn.
+ * In apply mode (-a) the lines are the desired state of the links, diffed
+ * against one dump of the current one: only what differs is sent.
+ */
+
+#define _GNU_SOURCE	/* sendmmsg, recvmmsg */
+
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
-#include <libintl.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/socket.h>
 
-int main(int argc, char *argv[])
+#include <linux/genetlink.h>
+#include <linux/if.h>
+#include <linux/if_link.h>
+#include <linux/rtnetlink.h>
+
+#include <libnl3/netlink/netlink.h>
+#include <libnl3/netlink/msg.h>
+#include <libnl3/netlink/attr.h>
+#include <libnl3/netlink/socket.h>
+
+#include "dummy_iface_macro.h"
+#include "dummy_iface_link.h"
+#include "dummy_iface_attr.h"
+#include "dummy_iface_genl.h"
+
+/* Requests per sendmmsg() and ACKs per recvmmsg() */
+#define DI_TX_BATCH		64
+#define DI_RX_BATCH		64
+#define DI_RX_BUF_SIZE		4096
+#define DI_DEFAULT_WINDOW	256
+#define DI_DEFAULT_RCVBUF	(4 * 1024 * 1024)
+/* Longest wait for an ACK: rtnetlink answers from within sendmsg() */
+#define DI_ACK_TIMEOUT_MS	1000
+#define DI_MAX_ARGS		64
+
+/* A request in flight, at slot seq % window */
+struct dummy_iface_slot {
+	uint32_t seq;
+	bool busy;
+	unsigned int line;
+	const char *op;
+	char ifname[DI_IFNAMSIZ];
+};
+
+/* The dummy_iface links of the namespace by name, from one dump */
+struct dummy_iface_state {
+	struct dummy_iface_link *links;
+	unsigned int nr;
+	unsigned int size;
+	int *index;		/* open addressing on the name, -1: empty */
+	unsigned int mask;
+};
+
+struct dummy_iface_context {
+	struct nl_sock *sk;
+	int fd;
+	uint32_t seq;
+
+	/* Requests in flight */
+	struct dummy_iface_slot *slots;
+	unsigned int window;
+	unsigned int inflight;
+	bool overrun;		/* ENOBUFS: ACKs were dropped */
+
+	/* Built, not sent yet */
+	struct nl_msg *batch[DI_TX_BATCH];
+	int batch_len;
+
+	/* Apply mode: the current state to diff against */
+	struct dummy_iface_state *state;
+	unsigned long unchanged;
+
+	unsigned long requests;
+	unsigned long failed;
+};
+
+/* What a command line is turned into */
+struct dummy_iface_request {
+	int type;
+	int flags;
+	const char *op;		/* static */
+	char ifname[DI_IFNAMSIZ];
+	uint32_t ifi_flags;
+	uint32_t ifi_change;
+	uint32_t mtu;
+	uint32_t txqueues;
+	uint32_t rxqueues;
+	uint32_t count;
+	int addr_len;
+	uint8_t addr[DI_ADDR_LEN];
+	uint32_t present;		/* DI_REQ_* */
+	uint64_t attrs_present;		/* dummy_iface_attrs bits */
+	uint64_t nest_present;		/* ATTR_NEST bits */
+	struct dummy_iface_params params;
+};
+
+#define DI_REQ_MTU		(1 << 0)
+#define DI_REQ_TXQUEUES		(1 << 1)
+#define DI_REQ_RXQUEUES		(1 << 2)
+#define DI_REQ_COUNT		(1 << 3)
+
+/* "aa:bb:cc" or "aabbcc" into @buf, returns the byte count */
+static int di_parse_hex(const char *str, uint8_t *buf, int size)
+{
+	int n = 0;
+
+	while (*str) {
+		if (*str == ':') {
+			str++;
+			continue;
+		}
+		if (n == size || !isxdigit(str[0]) || !isxdigit(str[1]))
+			return -1;
+		sscanf(str, "%2hhx", &buf[n++]);
+		str += 2;
+	}
+
+	return n;
+}
+
+static int di_parse_u64(const char *str, uint64_t max, uint64_t *val)
+{
+	char *end;
+
+	errno = 0;
+	*val = strtoull(str, &end, 0);
+	if (errno || end == str || *end || *val > max || *str == '-')
+		return -1;
+
+	return 0;
+}
+
+static int di_parse_cpus(const char *str, struct dummy_iface_cpus *cpus)
+{
+	char *end;
+	long cpu;
+
+	memset(cpus, 0, sizeof(*cpus));
+	while (*str) {
+		if (cpus->nr == DI_QUEUE_CPUS)
+			return -1;
+		cpu = strtol(str, &end, 0);
+		if (end == str || cpu < -1 || cpu > INT32_MAX ||
+		    (*end && *end != ','))
+			return -1;
+		cpus->cpu[cpus->nr++] = cpu;
+		str = *end ? end + 1 : end;
+	}
+
+	return 0;
+}
+
+static const struct dummy_iface_attr *di_attr_lookup(
+		const struct dummy_iface_attr *table, int maxtype,
+		const char *name, int *type)
+{
+	int i;
+
+	for (i = 0; i <= maxtype; ++i) {
+		if (table[i].name && !strcasecmp(table[i].name, name)) {
+			*type = i;
+			return &table[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* A value of one of the dummy_iface_attrs, into req->params */
+static int di_parse_attr(const struct dummy_iface_attr *a, const char *str,
+		struct dummy_iface_request *req)
+{
+	char *field = (char *)&req->params + a->offset;
+	uint64_t val;
+	int n;
+
+	if (a->type == NLA_UNSPEC) {
+		memset(field, 0, a->len);
+		n = di_parse_hex(str, (uint8_t *)field, a->len);
+		return n < 0 ? -1 : 0;
+	}
+
+	if (a->type == NLA_BINARY)
+		return di_parse_cpus(str, (struct dummy_iface_cpus *)field);
+
+	if (!strcasecmp(a->name, "MODE")) {
+		if (!strcasecmp(str, "sink"))
+			str = "0";
+		else if (!strcasecmp(str, "loopback"))
+			str = "1";
+	}
+
+	if (di_parse_u64(str, a->len < 8 ? (1ULL << (a->len * 8)) - 1 :
+			UINT64_MAX, &val))
+		return -1;
+
+	switch (a->len) {
+	case 1:
+		*(uint8_t *)field = val;
+		break;
+	case 2:
+		*(uint16_t *)field = val;
+		break;
+	case 4:
+		*(uint32_t *)field = val;
+		break;
+	case 8:
+		*(uint64_t *)field = val;
+		break;
+	}
+
+	return 0;
+}
+
+/* "NAME value" pairs of a command, @argv[0] is the first name */
+static int di_parse_opts(int argc, char **argv,
+		struct dummy_iface_request *req, const char **bad)
 {
+	const struct dummy_iface_attr *nest = &dummy_iface_attrs[IFLA_DUMMY_IFACE_ATTR_NEST];
+	const struct dummy_iface_attr *a;
+	uint64_t val;
+	int i, type;
+
+	for (i = 0; i < argc; ++i) {
+		const char *key = argv[i], *arg = argv[i + 1];
+
+		*bad = key;
+
+		if (!strcasecmp(key, "up") || !strcasecmp(key, "down")) {
+			req->ifi_change |= IFF_UP;
+			req->ifi_flags = !strcasecmp(key, "up") ? IFF_UP : 0;
+			continue;
+		}
+
+		if (!arg)
+			return -1;
+		i++;
+
+		if (!strcasecmp(key, "mtu")) {
+			if (di_parse_u64(arg, UINT32_MAX, &val))
+				return -1;
+			req->mtu = val;
+			req->present |= DI_REQ_MTU;
+		} else if (!strcasecmp(key, "address")) {
+			req->addr_len = di_parse_hex(arg, req->addr,
+					sizeof(req->addr));
+			if (req->addr_len <= 0)
+				return -1;
+		} else if (!strcasecmp(key, "txqueues") ||
+			   !strcasecmp(key, "rxqueues")) {
+			if (req->type != RTM_NEWLINK ||
+			    !(req->flags & NLM_F_CREATE) ||
+			    di_parse_u64(arg, UINT32_MAX, &val) || !val)
+				return -1;
+			if (key[0] == 't' || key[0] == 'T') {
+				req->txqueues = val;
+				req->present |= DI_REQ_TXQUEUES;
+			} else {
+				req->rxqueues = val;
+				req->present |= DI_REQ_RXQUEUES;
+			}
+		} else if (!strcasecmp(key, "count")) {
+			if (!(req->flags & NLM_F_CREATE) ||
+			    di_parse_u64(arg, UINT32_MAX, &val))
+				return -1;
+			req->count = val;
+			req->present |= DI_REQ_COUNT;
+		} else if ((a = di_attr_lookup(nest->nest, nest->nest_max,
+				key, &type))) {
+			if (di_parse_attr(a, arg, req))
+				return -1;
+			req->nest_present |= 1ULL << type;
+		} else if ((a = di_attr_lookup(dummy_iface_attrs,
+				IFLA_DUMMY_IFACE_EXT_MAX, key, &type)) &&
+			   a->type != NLA_NESTED) {
+			if (di_parse_attr(a, arg, req))
+				return -1;
+			req->attrs_present |= 1ULL << type;
+		} else {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int di_put_attrs(struct nl_msg *msg, const struct dummy_iface_attr *table,
+		int maxtype, uint64_t present,
+		const struct dummy_iface_params *params)
+{
+	int i, err;
+
+	for (i = 0; i <= maxtype; ++i) {
+		const void *field = (const char *)params + table[i].offset;
+
+		if (!(present & (1ULL << i)))
+			continue;
+		if (table[i].type == NLA_BINARY) {
+			const struct dummy_iface_cpus *cpus = field;
+
+			err = nla_put(msg, i, cpus->nr * sizeof(int32_t),
+					cpus->cpu);
+		} else {
+			err = nla_put(msg, i, table[i].len, field);
+		}
+		if (err)
+			return err;
+	}
+
 	return 0;
 }
+
+/* IFLA_LINKINFO { KIND, DATA { IFLA_DUMMY_IFACE_* } } */
+static int di_put_linkinfo(struct nl_msg *msg,
+		const struct dummy_iface_request *req)
+{
+	const struct dummy_iface_attr *nest = &dummy_iface_attrs[IFLA_DUMMY_IFACE_ATTR_NEST];
+	struct nlattr *info, *data, *attrs;
+	int err;
+
+	info = nla_nest_start(msg, IFLA_LINKINFO);
+	if (!info)
+		return -NLE_NOMEM;
+
+	err = nla_put_string(msg, IFLA_INFO_KIND, DUMMY_IFACE_KIND);
+	if (err)
+		return err;
+
+	data = nla_nest_start(msg, IFLA_INFO_DATA);
+	if (!data)
+		return -NLE_NOMEM;
+
+	err = di_put_attrs(msg, dummy_iface_attrs, IFLA_DUMMY_IFACE_EXT_MAX,
+			req->attrs_present, &req->params);
+	if (err)
+		return err;
+
+	if (req->nest_present) {
+		attrs = nla_nest_start(msg, IFLA_DUMMY_IFACE_ATTR_NEST);
+		if (!attrs)
+			return -NLE_NOMEM;
+		err = di_put_attrs(msg, nest->nest, nest->nest_max,
+				req->nest_present, &req->params);
+		if (err)
+			return err;
+		nla_nest_end(msg, attrs);
+	}
+
+	if (req->present & DI_REQ_COUNT)
+		NLA_PUT_U32(msg, IFLA_DUMMY_IFACE_COUNT, req->count);
+
+	nla_nest_end(msg, data);
+	nla_nest_end(msg, info);
+
+	return 0;
+
+nla_put_failure:
+	return -NLE_NOMEM;
+}
+
+static struct nl_msg *di_build(const struct dummy_iface_request *req)
+{
+	struct ifinfomsg ifi = {
+		.ifi_family	= AF_UNSPEC,
+		.ifi_flags	= req->ifi_flags,
+		.ifi_change	= req->ifi_change,
+	};
+	struct nl_msg *msg;
+
+	msg = nlmsg_alloc_simple(req->type,
+			NLM_F_REQUEST | NLM_F_ACK | req->flags);
+	if (!msg)
+		return NULL;
+
+	if (nlmsg_append(msg, &ifi, sizeof(ifi), NLMSG_ALIGNTO))
+		goto nla_put_failure;
+
+	NLA_PUT_STRING(msg, IFLA_IFNAME, req->ifname);
+
+	if (req->type == RTM_DELLINK)
+		return msg;
+
+	if (req->present & DI_REQ_MTU)
+		NLA_PUT_U32(msg, IFLA_MTU, req->mtu);
+	if (req->addr_len)
+		NLA_PUT(msg, IFLA_ADDRESS, req->addr_len, req->addr);
+	if (req->present & DI_REQ_TXQUEUES)
+		NLA_PUT_U32(msg, IFLA_NUM_TX_QUEUES, req->txqueues);
+	if (req->present & DI_REQ_RXQUEUES)
+		NLA_PUT_U32(msg, IFLA_NUM_RX_QUEUES, req->rxqueues);
+
+	/* Without driver attributes a change applies to any kind of link */
+	if ((req->flags & NLM_F_CREATE) || req->attrs_present ||
+	    req->nest_present) {
+		if (di_put_linkinfo(msg, req))
+			goto nla_put_failure;
+	}
+
+	return msg;
+
+nla_put_failure:
+	nlmsg_free(msg);
+	return NULL;
+}
+
+/* One command: its words in @argv, 0 when it is a link request in @req,
+ * 1 for "stats", -1 when it is malformed.
+ */
+static int di_parse_cmd(int argc, char **argv, struct dummy_iface_request *req,
+		const char **bad)
+{
+	memset(req, 0, sizeof(*req));
+	*bad = argv[0];
+
+	if (!strcmp(argv[0], "stats"))
+		return argc == 1 ? 1 : -1;
+
+	if (!strcmp(argv[0], "add")) {
+		req->type = RTM_NEWLINK;
+		req->flags = NLM_F_CREATE | NLM_F_EXCL;
+		req->op = "add";
+	} else if (!strcmp(argv[0], "set")) {
+		/* RTM_SETLINK does not reach ->changelink(), a NEWLINK of
+		 * an existing device with its IFLA_INFO_DATA does.
+		 */
+		req->type = RTM_NEWLINK;
+		req->op = "set";
+	} else if (!strcmp(argv[0], "del")) {
+		req->type = RTM_DELLINK;
+		req->op = "del";
+	} else {
+		return -1;
+	}
+
+	if (argc < 2 || strlen(argv[1]) >= DI_IFNAMSIZ) {
+		*bad = argc < 2 ? argv[0] : argv[1];
+		return -1;
+	}
+	strcpy(req->ifname, argv[1]);
+
+	if (req->type == RTM_DELLINK)
+		return argc == 2 ? 0 : -1;
+
+	return di_parse_opts(argc - 2, argv + 2, req, bad);
+}
+
+static void di_set_rcvbuf(int fd, int size)
+{
+	/* SO_RCVBUFFORCE ignores net.core.rmem_max but needs CAP_NET_ADMIN */
+	if (!setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)))
+		return;
+
+	if (setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)))
+		perror("Failed to set socket receive buffer");
+}
+
+static void di_complete(struct dummy_iface_context *ctx,
+		struct dummy_iface_slot *slot, int error)
+{
+	if (error) {
+		fprintf(stderr, "line %u: %s %s: %s\n", slot->line, slot->op,
+				slot->ifname, strerror(-error));
+		ctx->failed++;
+	}
+
+	slot->busy = false;
+	ctx->inflight--;
+}
+
+static void di_ack(struct dummy_iface_context *ctx, struct nlmsghdr *hdr,
+		int len)
+{
+	struct dummy_iface_slot *slot;
+	struct nlmsgerr *e;
+
+	for (; nlmsg_ok(hdr, len); hdr = nlmsg_next(hdr, &len)) {
+		if (hdr->nlmsg_type != NLMSG_ERROR)
+			continue;
+
+		slot = &ctx->slots[hdr->nlmsg_seq % ctx->window];
+		if (!slot->busy || slot->seq != hdr->nlmsg_seq)
+			continue;
+
+		e = nlmsg_data(hdr);
+		di_complete(ctx, slot, e->error);
+	}
+}
+
+/* Every request still in flight once the socket is drained after an
+ * overrun had its ACK dropped: rtnetlink answers before sendmsg()
+ * returns, so nothing else is coming.
+ */
+static void di_expire(struct dummy_iface_context *ctx, int error)
+{
+	unsigned int i;
+
+	for (i = 0; i < ctx->window && ctx->inflight; ++i)
+		if (ctx->slots[i].busy)
+			di_complete(ctx, &ctx->slots[i], error);
+
+	ctx->overrun = false;
+}
+
+/* Match the ACKs the socket holds, DI_RX_BATCH per syscall. With @wait,
+ * until nothing is in flight.
+ */
+static int di_drain(struct dummy_iface_context *ctx, bool wait)
+{
+	static char bufs[DI_RX_BATCH][DI_RX_BUF_SIZE];
+	static struct iovec iov[DI_RX_BATCH];
+	static struct mmsghdr msgs[DI_RX_BATCH];
+	struct pollfd pfd = { .fd = ctx->fd, .events = POLLIN };
+	int i, n;
+
+	for (i = 0; i < DI_RX_BATCH; ++i) {
+		iov[i].iov_base = bufs[i];
+		iov[i].iov_len = DI_RX_BUF_SIZE;
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	while (ctx->inflight) {
+		n = recvmmsg(ctx->fd, msgs, DI_RX_BATCH, MSG_DONTWAIT, NULL);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == ENOBUFS) {
+				ctx->overrun = true;
+				continue;
+			}
+			if (errno != EAGAIN) {
+				perror("Failed to receive ACKs");
+				return -1;
+			}
+
+			if (ctx->overrun) {
+				di_expire(ctx, -ENOBUFS);
+				continue;
+			}
+			if (!wait)
+				return 0;
+
+			n = poll(&pfd, 1, DI_ACK_TIMEOUT_MS);
+			if (n < 0 && errno != EINTR) {
+				perror("Failed to wait for ACKs");
+				return -1;
+			}
+			if (!n)
+				di_expire(ctx, -ETIMEDOUT);
+			continue;
+		}
+
+		for (i = 0; i < n; ++i)
+			di_ack(ctx, (struct nlmsghdr *)bufs[i], msgs[i].msg_len);
+	}
+
+	return 0;
+}
+
+/* Send the built batch with as few sendmmsg() as the kernel takes */
+static int di_flush(struct dummy_iface_context *ctx)
+{
+	struct sockaddr_nl kernel = { .nl_family = AF_NETLINK };
+	struct mmsghdr msgs[DI_TX_BATCH];
+	struct iovec iov[DI_TX_BATCH];
+	int i, n, sent = 0, err = 0;
+
+	memset(msgs, 0, sizeof(msgs));
+	for (i = 0; i < ctx->batch_len; ++i) {
+		struct nlmsghdr *hdr = nlmsg_hdr(ctx->batch[i]);
+
+		iov[i].iov_base = hdr;
+		iov[i].iov_len = hdr->nlmsg_len;
+		msgs[i].msg_hdr.msg_name = &kernel;
+		msgs[i].msg_hdr.msg_namelen = sizeof(kernel);
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	while (sent < ctx->batch_len) {
+		n = sendmmsg(ctx->fd, msgs + sent, ctx->batch_len - sent, 0);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("Failed to send requests");
+			err = -1;
+			break;
+		}
+		sent += n;
+	}
+
+	for (i = 0; i < ctx->batch_len; ++i)
+		nlmsg_free(ctx->batch[i]);
+	ctx->batch_len = 0;
+
+	return err;
+}
+
+static int di_submit(struct dummy_iface_context *ctx,
+		const struct dummy_iface_request *req, unsigned int line)
+{
+	struct dummy_iface_slot *slot;
+	struct nl_msg *msg;
+
+	/* The slot of the next sequence number must be free: send what is
+	 * built and match the ACKs it got, wait only when that is not enough.
+	 */
+	slot = &ctx->slots[(ctx->seq + 1) % ctx->window];
+	if (slot->busy) {
+		if (di_flush(ctx) || di_drain(ctx, false))
+			return -1;
+		if (slot->busy && di_drain(ctx, true))
+			return -1;
+	}
+
+	msg = di_build(req);
+	if (!msg) {
+		fprintf(stderr, "line %u: %s %s: message too long\n", line,
+				req->op, req->ifname);
+		ctx->failed++;
+		return 0;
+	}
+
+	ctx->seq++;
+	nlmsg_hdr(msg)->nlmsg_seq = ctx->seq;
+	nlmsg_hdr(msg)->nlmsg_pid = nl_socket_get_local_port(ctx->sk);
+
+	slot->seq = ctx->seq;
+	slot->busy = true;
+	slot->line = line;
+	slot->op = req->op;
+	strcpy(slot->ifname, req->ifname);
+	ctx->inflight++;
+	ctx->requests++;
+
+	ctx->batch[ctx->batch_len++] = msg;
+	if (ctx->batch_len < DI_TX_BATCH)
+		return 0;
+
+	if (di_flush(ctx) || di_drain(ctx, false))
+		return -1;
+
+	return 0;
+}
+
+static int di_stats(struct dummy_iface_context *ctx)
+{
+	static const char * const names[DUMMY_IFACE_STATS_MAX + 1] = {
+		[DUMMY_IFACE_STATS_DEVICES]	= "devices",
+		[DUMMY_IFACE_STATS_FILL_CALLS]	= "fill_calls",
+		[DUMMY_IFACE_STATS_FILL_BYTES]	= "fill_bytes",
+		[DUMMY_IFACE_STATS_DUMPS]	= "dumps",
+		[DUMMY_IFACE_STATS_DUMP_MSGS]	= "dump_msgs",
+		[DUMMY_IFACE_STATS_DUMP_DEVS]	= "dump_devs",
+		[DUMMY_IFACE_STATS_DUMP_NS]	= "dump_ns",
+	};
+	uint64_t stats[DUMMY_IFACE_STATS_MAX + 1];
+	struct nl_sock *sk;
+	int i, err, family, group;
+
+	/* Done with what was asked before */
+	if (di_flush(ctx) || di_drain(ctx, true))
+		return -1;
+
+	sk = nl_socket_alloc();
+	if (!sk)
+		return -1;
+
+	err = nl_connect(sk, NETLINK_GENERIC);
+	if (!err)
+		err = dummy_iface_genl_resolve(sk, &family, &group);
+	if (!err)
+		err = dummy_iface_genl_get_stats(sk, family, stats);
+	nl_socket_free(sk);
+
+	if (err) {
+		fprintf(stderr, "Failed to get %s stats: %s\n",
+				DUMMY_IFACE_GENL_NAME, nl_geterror(err));
+		ctx->failed++;
+		return 0;
+	}
+
+	for (i = 0; i <= DUMMY_IFACE_STATS_MAX; ++i)
+		if (names[i])
+			printf("%s: %" PRIu64 "\n", names[i], stats[i]);
+
+	return 0;
+}
+
+static uint32_t di_name_hash(const char *name)
+{
+	uint32_t hash = 2166136261u;	/* FNV-1a */
+
+	while (*name)
+		hash = (hash ^ (uint8_t)*name++) * 16777619u;
+
+	return hash;
+}
+
+static struct dummy_iface_link *di_state_find(struct dummy_iface_state *state,
+		const char *name)
+{
+	unsigned int i;
+
+	if (!state->index)
+		return NULL;
+
+	for (i = di_name_hash(name) & state->mask; state->index[i] >= 0;
+	     i = (i + 1) & state->mask)
+		if (!strcmp(state->links[state->index[i]].ifname, name))
+			return &state->links[state->index[i]];
+
+	return NULL;
+}
+
+static int di_state_index(struct dummy_iface_state *state)
+{
+	unsigned int i, j, size = 16;
+
+	while (size < state->nr * 2)
+		size <<= 1;
+
+	state->index = malloc(size * sizeof(*state->index));
+	if (!state->index)
+		return -NLE_NOMEM;
+	memset(state->index, -1, size * sizeof(*state->index));
+	state->mask = size - 1;
+
+	for (i = 0; i < state->nr; ++i) {
+		j = di_name_hash(state->links[i].ifname) & state->mask;
+		while (state->index[j] >= 0)
+			j = (j + 1) & state->mask;
+		state->index[j] = i;
+	}
+
+	return 0;
+}
+
+/* A part of a DUMMY_IFACE_CMD_GETLINK dump into @state: 1 while more is
+ * to come, 0 once done. @intr tells the registry changed meanwhile.
+ */
+static int di_state_recv(struct nl_sock *sk, struct dummy_iface_state *state,
+		bool *intr)
+{
+	struct sockaddr_nl peer;
+	struct nlmsghdr *hdr;
+	unsigned char *buf = NULL;
+	int n, err = 1;
+
+	n = nl_recv(sk, &peer, &buf, NULL);
+	if (n <= 0)
+		return n ? n : -NLE_NODEV;
+
+	hdr = (struct nlmsghdr *)buf;
+	for (; err > 0 && nlmsg_ok(hdr, n); hdr = nlmsg_next(hdr, &n)) {
+		if (hdr->nlmsg_flags & NLM_F_DUMP_INTR)
+			*intr = true;
+		if (hdr->nlmsg_type == NLMSG_DONE) {
+			err = 0;
+			break;
+		}
+		if (hdr->nlmsg_type == NLMSG_ERROR) {
+			struct nlmsgerr *e = nlmsg_data(hdr);
+
+			err = -nl_syserr2nlerr(-e->error);
+			break;
+		}
+
+		if (state->nr == state->size) {
+			struct dummy_iface_link *links;
+
+			state->size = state->size ? state->size * 2 : 256;
+			links = realloc(state->links,
+					state->size * sizeof(*links));
+			if (!links) {
+				err = -NLE_NOMEM;
+				break;
+			}
+			state->links = links;
+		}
+
+		/* A link left out would be added again, and fail, on apply */
+		err = dummy_iface_link_parse_genl(hdr, &state->links[state->nr]);
+		if (err) {
+			fprintf(stderr, "Failed to decode a dumped link: %s\n",
+					nl_geterror(err));
+			break;
+		}
+		state->nr++;
+		err = 1;
+	}
+
+	free(buf);
+
+	return err;
+}
+
+/* The current state, from the module's own registry: the dump costs the
+ * dummy_iface links only, however many others the namespace has. No
+ * family, no module and no links.
+ */
+static int di_state_dump(struct dummy_iface_state *state)
+{
+	struct genlmsghdr ghdr = {
+		.cmd		= DUMMY_IFACE_CMD_GETLINK,
+		.version	= DUMMY_IFACE_GENL_VERSION,
+	};
+	struct nl_sock *sk;
+	struct nl_msg *msg;
+	int err, family, group;
+	bool intr = true;
+
+	sk = nl_socket_alloc();
+	if (!sk)
+		return -NLE_NOMEM;
+
+	nl_socket_disable_auto_ack(sk);
+	nl_socket_enable_msg_peek(sk);
+
+	err = nl_connect(sk, NETLINK_GENERIC);
+	if (!err)
+		err = dummy_iface_genl_resolve(sk, &family, &group);
+	if (err == -NLE_OBJ_NOTFOUND) {
+		err = 0;
+		goto index;
+	}
+
+	/* Dumped again until the registry holds still for a whole dump */
+	while (!err && intr) {
+		state->nr = 0;
+		intr = false;
+
+		msg = nlmsg_alloc_simple(family, NLM_F_DUMP);
+		if (!msg) {
+			err = -NLE_NOMEM;
+			break;
+		}
+		err = nlmsg_append(msg, &ghdr, sizeof(ghdr), NLMSG_ALIGNTO);
+		if (!err)
+			err = nl_send_auto(sk, msg);
+		nlmsg_free(msg);
+		if (err < 0)
+			break;
+
+		do {
+			err = di_state_recv(sk, state, &intr);
+		} while (err > 0);
+	}
+
+index:
+	if (!err)
+		err = di_state_index(state);
+	nl_socket_free(sk);
+
+	return err;
+}
+
+static void di_state_free(struct dummy_iface_state *state)
+{
+	free(state->links);
+	free(state->index);
+}
+
+/* Drop from @req what @cur already has. Returns whether anything is left
+ * to send.
+ */
+static bool di_diff(struct dummy_iface_request *req,
+		const struct dummy_iface_link *cur)
+{
+	const struct dummy_iface_attr *nest = &dummy_iface_attrs[IFLA_DUMMY_IFACE_ATTR_NEST];
+	const struct dummy_iface_attr *a;
+	int i;
+
+	for (i = 0; i <= IFLA_DUMMY_IFACE_EXT_MAX; ++i) {
+		a = &dummy_iface_attrs[i];
+		if ((req->attrs_present & cur->params_present & (1ULL << i)) &&
+		    !memcmp((char *)&req->params + a->offset,
+			    (char *)&cur->params + a->offset, a->len))
+			req->attrs_present &= ~(1ULL << i);
+	}
+
+	if (cur->params_present & (1ULL << IFLA_DUMMY_IFACE_ATTR_NEST)) {
+		for (i = 0; i <= nest->nest_max; ++i) {
+			a = &nest->nest[i];
+			if ((req->nest_present & (1ULL << i)) &&
+			    !memcmp((char *)&req->params + a->offset,
+				    (char *)&cur->params + a->offset, a->len))
+				req->nest_present &= ~(1ULL << i);
+		}
+	}
+
+	if ((req->present & DI_REQ_MTU) && (cur->present & DI_LINK_MTU) &&
+	    req->mtu == cur->mtu)
+		req->present &= ~DI_REQ_MTU;
+
+	if (req->addr_len && req->addr_len == cur->addr_len &&
+	    !memcmp(req->addr, cur->addr, req->addr_len))
+		req->addr_len = 0;
+
+	if (req->ifi_change && (cur->ifi_flags & IFF_UP) == req->ifi_flags) {
+		req->ifi_change = 0;
+		req->ifi_flags = 0;
+	}
+
+	return req->present || req->attrs_present || req->nest_present ||
+		req->addr_len || req->ifi_change;
+}
+
+/* A desired state line: "NAME [options]", a change of what differs from
+ * the dumped state or the creation of a link that is not there.
+ */
+static int di_apply(struct dummy_iface_context *ctx, int argc, char **argv,
+		unsigned int line)
+{
+	struct dummy_iface_request req;
+	struct dummy_iface_link *cur;
+	const char *bad;
+
+	/* argv[-1] is there for the command */
+	argv[-1] = "set";
+	if (di_parse_cmd(argc + 1, argv - 1, &req, &bad)) {
+		fprintf(stderr, "line %u: bad argument '%s'\n", line, bad);
+		ctx->failed++;
+		return 0;
+	}
+
+	cur = di_state_find(ctx->state, req.ifname);
+	if (!cur) {
+		req.flags = NLM_F_CREATE | NLM_F_EXCL;
+		req.op = "add";
+	} else if (!di_diff(&req, cur)) {
+		ctx->unchanged++;
+		return 0;
+	}
+
+	return di_submit(ctx, &req, line);
+}
+
+static int di_run(struct dummy_iface_context *ctx, int argc, char **argv,
+		unsigned int line)
+{
+	struct dummy_iface_request req;
+	const char *bad;
+	int ret;
+
+	ret = di_parse_cmd(argc, argv, &req, &bad);
+	if (ret < 0) {
+		fprintf(stderr, "line %u: bad argument '%s'\n", line, bad);
+		ctx->failed++;
+		return 0;
+	}
+	if (ret)
+		return di_stats(ctx);
+
+	return di_submit(ctx, &req, line);
+}
+
+static int di_run_file(struct dummy_iface_context *ctx, const char *path)
+{
+	char buf[4096], *args[DI_MAX_ARGS + 2], **argv = args + 1, *tok, *save;
+	unsigned int line = 0;
+	FILE *f;
+	int argc, err = 0;
+
+	f = strcmp(path, "-") ? fopen(path, "r") : stdin;
+	if (!f) {
+		perror("Failed to open command file");
+		return -1;
+	}
+
+	while (!err && fgets(buf, sizeof(buf), f)) {
+		line++;
+
+		tok = strchr(buf, '#');
+		if (tok)
+			*tok = '\0';
+
+		argc = 0;
+		for (tok = strtok_r(buf, " \t\r\n", &save);
+		     tok && argc < DI_MAX_ARGS;
+		     tok = strtok_r(NULL, " \t\r\n", &save))
+			argv[argc++] = tok;
+		argv[argc] = NULL;
+
+		if (!argc)
+			continue;
+		if (ctx->state)
+			err = di_apply(ctx, argc, argv, line);
+		else
+			err = di_run(ctx, argc, argv, line);
+	}
+
+	if (f != stdin)
+		fclose(f);
+
+	return err;
+}
+
+static double di_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [-w window] [-r bytes] [-v] {-f file | -a file | command}\n"
+		"  -f file   one command per line, '#' comments ('-' for stdin)\n"
+		"  -a file   desired state, 'NAME [options]' per line: links are\n"
+		"            created or changed where they differ from it\n"
+		"  -w window requests in flight (default %d)\n"
+		"  -r bytes  socket receive buffer (default %d)\n"
+		"  -v        print the request count and rate\n"
+		"Commands:\n"
+		"  add NAME [options]   create a %s link\n"
+		"  set NAME [options]   change a link\n"
+		"  del NAME             delete a link\n"
+		"  stats                dump cost counters of the namespace\n"
+		"Options:\n"
+		"  up | down | mtu N | address XX:XX:.. | txqueues N | rxqueues N\n"
+		"  count N | queue_cpus CPU[,CPU..] (-1: any)\n"
+		"  ATTR VALUE, ATTR: attr_0 attr_1 attr_2 nest_a nest_b attr_bin (hex)\n"
+		"                    mode (sink, loopback) drop delay jitter rate\n"
+		"                    burst gen_rate gen_len\n",
+		prog, DI_DEFAULT_WINDOW, DI_DEFAULT_RCVBUF, DUMMY_IFACE_KIND);
+}
+
+int main(int argc, char *argv[])
+{
+	int opt, err = -1, rcvbuf = DI_DEFAULT_RCVBUF, one = 1;
+	const char *file = NULL;
+	bool verbose = false;
+	struct dummy_iface_context ctx;
+	struct dummy_iface_state state;
+	double start;
+
+	memset(&ctx, 0, sizeof(ctx));
+	memset(&state, 0, sizeof(state));
+	ctx.window = DI_DEFAULT_WINDOW;
+
+	while ((opt = getopt(argc, argv, "+f:a:w:r:vh")) != -1) {
+		switch (opt) {
+		case 'f':
+		case 'a':
+			if (file) {
+				usage(argv[0]);
+				return 1;
+			}
+			file = optarg;
+			if (opt == 'a')
+				ctx.state = &state;
+			break;
+		case 'w':
+			ctx.window = atoi(optarg);
+			break;
+		case 'r':
+			rcvbuf = atoi(optarg);
+			break;
+		case 'v':
+			verbose = true;
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (!ctx.window || (!file) == (optind == argc)) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	ctx.slots = calloc(ctx.window, sizeof(*ctx.slots));
+	ctx.sk = nl_socket_alloc();
+	if (!ctx.slots || !ctx.sk) {
+		fprintf(stderr, "Failed to allocate\n");
+		goto free_ctx;
+	}
+
+	if (nl_connect(ctx.sk, NETLINK_ROUTE)) {
+		perror("Failed to connect to netlink");
+		goto free_ctx;
+	}
+	ctx.fd = nl_socket_get_fd(ctx.sk);
+
+	/* ACKs of failed requests need not carry the request back */
+	setsockopt(ctx.fd, SOL_NETLINK, NETLINK_CAP_ACK, &one, sizeof(one));
+	di_set_rcvbuf(ctx.fd, rcvbuf);
+
+	start = di_now();
+
+	if (ctx.state) {
+		err = di_state_dump(ctx.state);
+		if (err) {
+			fprintf(stderr, "Failed to dump %s links: %s\n",
+					DUMMY_IFACE_KIND, nl_geterror(err));
+			goto free_ctx;
+		}
+	}
+
+	if (file)
+		err = di_run_file(&ctx, file);
+	else
+		err = di_run(&ctx, argc - optind, argv + optind, 1);
+
+	if (!err)
+		err = di_flush(&ctx);
+	if (!err)
+		err = di_drain(&ctx, true);
+
+	if (verbose) {
+		double elapsed = di_now() - start;
+
+		if (ctx.state)
+			fprintf(stderr, "%u links, %lu unchanged\n",
+					state.nr, ctx.unchanged);
+		fprintf(stderr, "%lu requests, %lu failed, %.3f s, %.0f req/s\n",
+				ctx.requests, ctx.failed, elapsed,
+				elapsed > 0 ? ctx.requests / elapsed : 0);
+	}
+
+	if (!err && ctx.failed)
+		err = 1;
+
+free_ctx:
+	nl_socket_free(ctx.sk);
+	free(ctx.slots);
+	di_state_free(&state);
+
+	return err ? 1 : 0;
+}
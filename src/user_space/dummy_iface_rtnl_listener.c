@@ -5,10 +5,19 @@
  *      Author: oivantsiv
  */
 
+#define _GNU_SOURCE	/* recvmmsg */
+
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
 #include <inttypes.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
+
+#include <linux/genetlink.h>
 
 #include <linux/if_link.h>
 #include <linux/netdevice.h>
@@ -17,239 +26,614 @@
 #include <libnl3/netlink/msg.h>
 #include <libnl3/netlink/attr.h>
 #include <libnl3/netlink/socket.h>
+#include <libnl3/netlink/utils.h>
 
 #include "dummy_iface_macro.h"
+#include "dummy_iface_link.h"
+#include "dummy_iface_attr.h"
+#include "dummy_iface_event.h"
+#include "dummy_iface_cache.h"
+#include "dummy_iface_genl.h"
+#include "dummy_iface_coalesce.h"
+#include "dummy_iface_bufpool.h"
+#include "dummy_iface_pipeline.h"
+#include "dummy_iface_nla.h"
+
+/* Event loop mode (-e): datagrams read per recvmmsg() and their size.
+ * RTM_GETLINK dump parts are the largest messages we get.
+ */
+#define DI_RX_BATCH		64
+#define DI_RX_BUF_SIZE		32768
+/* Receive buffers, enough for the ones held by the decode workers */
+#define DI_RX_POOL		(4 * DI_RX_BATCH)
+#define DI_DEFAULT_RCVBUF	(16 * 1024 * 1024)
 
 struct dummy_iface_context {
 	struct nl_sock *sk;
-};
 
-typedef int (*dummy_iface_nla_cb)(int attr, struct nlattr *nla, void *context);
+	/* Event loop mode */
+	int rcvbuf;
+	bool dump_pending;	/* RTM_GETLINK dump in flight */
+	bool resync;		/* dump again once the pending one is done */
+	unsigned long overruns;	/* ENOBUFS seen on the socket */
+	struct dummy_iface_bufpool *pool;
+	struct dummy_iface_buf *rx_buf;	/* the datagram being handled */
 
-struct dummy_iface_nla_handler {
-	dummy_iface_nla_cb cb;
-};
+	/* Message being decoded */
+	struct dummy_iface_link link;
 
-static int di_ifla_ifname_handler(int attr, struct nlattr *nla, void *context);
-static int di_ifla_address_handler(int attr, struct nlattr *nla, void *context);
-static int di_ifla_mtu_handler(int attr, struct nlattr *nla, void *context);
-static int di_ifla_link_handler(int attr, struct nlattr *nla, void *context);
-static int di_ifla_linkinfo_handler(int attr, struct nlattr *nla, void *context);
+	/* Non-verbose mode (-b/-s): binary records instead of text */
+	bool binary;
+	struct dummy_iface_event_out out;
 
-static int di_ifla_info_kind_handler(int attr, struct nlattr *nla, void *context);
-static int di_ifla_info_data_handler(int attr, struct nlattr *nla, void *context);
+	/* Link state cache (-c), NULL if not kept */
+	struct dummy_iface_cache *cache;
 
-static int di_ifla_di_attr_0_handler(int attr, struct nlattr *nla, void *context);
-static int di_ifla_di_attr_1_handler(int attr, struct nlattr *nla, void *context);
-static int di_ifla_di_attr_2_handler(int attr, struct nlattr *nla, void *context);
-static int di_ifla_di_attr_nest_handler(int attr, struct nlattr *nla, void *context);
-static int di_ifla_di_attr_bin_handler(int attr, struct nlattr *nla, void *context);
+	/* dummy_iface generic netlink family (-g), 0 for rtnetlink */
+	int genl_family;
 
-static const char *rtmtostr(int type);
+	/* rtnetlink: dummy_iface links only (-k) */
+	bool kind_only;
 
-static struct nla_policy ifla_policy[IFLA_MAX+1] = {
-	[IFLA_IFNAME]		= { .type = NLA_STRING, .maxlen = IFNAMSIZ-1 },
-	[IFLA_ADDRESS]		= {  .maxlen = MAX_ADDR_LEN },
-	[IFLA_BROADCAST]	= {  .maxlen = MAX_ADDR_LEN },
-	[IFLA_MAP]		= {  .maxlen = sizeof(struct rtnl_link_ifmap) },
-	[IFLA_MTU]		= { .type = NLA_U32 },
-	[IFLA_LINK]		= { .type = NLA_U32 },
-	[IFLA_MASTER]		= { .type = NLA_U32 },
-	[IFLA_CARRIER]		= { .type = NLA_U8 },
-	[IFLA_TXQLEN]		= { .type = NLA_U32 },
-	[IFLA_WEIGHT]		= { .type = NLA_U32 },
-	[IFLA_OPERSTATE]	= { .type = NLA_U8 },
-	[IFLA_LINKMODE]		= { .type = NLA_U8 },
-	[IFLA_LINKINFO]		= { .type = NLA_NESTED },
-	[IFLA_NET_NS_PID]	= { .type = NLA_U32 },
-	[IFLA_NET_NS_FD]	= { .type = NLA_U32 },
-	[IFLA_IFALIAS]		= { .type = NLA_STRING, .maxlen = IFALIASZ-1 },
-	[IFLA_VFINFO_LIST]	= {. type = NLA_NESTED },
-	[IFLA_VF_PORTS]		= { .type = NLA_NESTED },
-	[IFLA_PORT_SELF]	= { .type = NLA_NESTED },
-	[IFLA_AF_SPEC]		= { .type = NLA_NESTED },
-	[IFLA_EXT_MASK]		= { .type = NLA_U32 },
-	[IFLA_PROMISCUITY]	= { .type = NLA_U32 },
-	[IFLA_NUM_TX_QUEUES]	= { .type = NLA_U32 },
-	[IFLA_NUM_RX_QUEUES]	= { .type = NLA_U32 },
-	[IFLA_PHYS_PORT_ID]	= { .maxlen = MAX_ADDR_LEN },
-	[IFLA_CARRIER_CHANGES]	= { .type = NLA_U32 },  /* ignored */
-};
+	/* Coalescing (-W), NULL when events are delivered as they come */
+	struct dummy_iface_coalesce *coalesce;
 
-static struct dummy_iface_nla_handler ifla_nla_handler[IFLA_MAX+1] = {
-	[IFLA_IFNAME]		= { .cb = di_ifla_ifname_handler },
-	[IFLA_ADDRESS]		= { .cb = di_ifla_address_handler },
-	[IFLA_MTU]		= { .cb = di_ifla_mtu_handler },
-	[IFLA_LINK]		= { .cb = di_ifla_link_handler },
-	[IFLA_LINKINFO]		= { .cb = di_ifla_linkinfo_handler },
+	/* Decode workers (-t), NULL to decode on the receive thread */
+	struct dummy_iface_pipeline *pipeline;
 };
 
-static struct nla_policy ifla_info_policy[IFLA_INFO_MAX+1] = {
-	[IFLA_INFO_KIND]	= { .type = NLA_STRING },
-	[IFLA_INFO_DATA]	= { .type = NLA_NESTED },
-	[IFLA_INFO_SLAVE_KIND]	= { .type = NLA_STRING },
-	[IFLA_INFO_SLAVE_DATA]	= { .type = NLA_NESTED },
+/* Dump boundaries for the cache, in order with the links in between */
+enum {
+	DI_MARK_DUMP_BEGIN,
+	DI_MARK_DUMP_END,
 };
 
-static struct dummy_iface_nla_handler ifla_info_nla_handler[IFLA_INFO_MAX+1] = {
-	[IFLA_INFO_KIND]	= { .cb = di_ifla_info_kind_handler },
-	[IFLA_INFO_DATA]	= { .cb = di_ifla_info_data_handler },
-};
+static const char *rtmtostr(int type);
+static void di_handle_stream(struct nlmsghdr *stream, int rem, void *context);
+static void di_dump_mark(struct dummy_iface_context *ctx, uint32_t mark);
+static int di_event_loop(struct dummy_iface_context *ctx);
 
-static struct nla_policy di_policy[IFLA_DUMMY_IFACE_MAX+1] = {
-	[IFLA_DUMMY_IFACE_ATTR_0]	= { .type = NLA_U8 },
-	[IFLA_DUMMY_IFACE_ATTR_1]	= { .type = NLA_U16 },
-	[IFLA_DUMMY_IFACE_ATTR_2]	= { .type = NLA_U32 },
-	[IFLA_DUMMY_IFACE_ATTR_NEST]	= { .type = NLA_NESTED},
-	[IFLA_DUMMY_IFACE_ATTR_BIN]	= { .maxlen = sizeof(struct ifla_dummy_iface_bin_attr)}
-};
+static int di_valid_msg_cb(struct nl_msg *msg, void *context)
+{
+	struct dummy_iface_context *ctx = context;
 
-static struct dummy_iface_nla_handler ifla_di_nla_handler[IFLA_DUMMY_IFACE_MAX+1] = {
-	[IFLA_DUMMY_IFACE_ATTR_0]	= { .cb = di_ifla_di_attr_0_handler },
-	[IFLA_DUMMY_IFACE_ATTR_1]	= { .cb = di_ifla_di_attr_1_handler },
-	[IFLA_DUMMY_IFACE_ATTR_2]	= { .cb = di_ifla_di_attr_2_handler },
-	[IFLA_DUMMY_IFACE_ATTR_NEST]	= { .cb = di_ifla_di_attr_nest_handler },
-	[IFLA_DUMMY_IFACE_ATTR_BIN]	= { .cb = di_ifla_di_attr_bin_handler },
-};
+	if (!ctx->binary)
+		DI_TRACE_CALL(err);
 
+	di_handle_stream(nlmsg_hdr(msg), nlmsg_get_max_size(msg), context);
 
-static int di_valid_msg_cb(struct nl_msg *msg, void *context)
+	return 0;
+}
+
+/* IFLA_INFO_KIND in the RTM_GETLINK dump request. Only kernels from 4.15
+ * filter on it, those the module builds for dump every link and
+ * di_decode drops the others in user space. Only the -g dump is filtered
+ * in the kernel, which walks the module's own devices only.
+ */
+static int di_put_kind_filter(struct nl_msg *msg)
 {
-	int i, err, rem;
-	struct nlmsghdr *hdr, *stream;
-	struct nlattr *ifla_tb[IFLA_MAX+1];
-	int ifla_attrs_to_parse[] = { IFLA_IFNAME, IFLA_ADDRESS, IFLA_MTU,
-			IFLA_LINK, IFLA_LINKINFO };
+	struct nlattr *linkinfo;
 
-	DI_TRACE_CALL(err);
+	linkinfo = nla_nest_start(msg, IFLA_LINKINFO);
+	if (!linkinfo)
+		return -NLE_NOMEM;
 
-	stream = nlmsg_hdr(msg);
-	rem = nlmsg_get_max_size(msg);
+	if (nla_put_string(msg, IFLA_INFO_KIND, DUMMY_IFACE_KIND))
+		return -NLE_NOMEM;
 
-	for (hdr = stream; nlmsg_ok(hdr, rem); hdr = nlmsg_next(hdr, &rem)) {
-		printf("Message:\n");
-		printf("    Type:  %s\n", rtmtostr(hdr->nlmsg_type));
-		printf("    PID:   %"PRIu32"\n", hdr->nlmsg_pid);
-		printf("    Len:   %"PRIu32"\n", hdr->nlmsg_len);
-		printf("    Seq:   %"PRIu32"\n", hdr->nlmsg_seq);
-		printf("    Flags: %"PRIu32"\n\n", hdr->nlmsg_flags);
-
-		err = nlmsg_parse(hdr, NLMSG_HDRLEN, ifla_tb,
-				IFLA_MAX, ifla_policy);
-		if (err) {
-			perror("Failed to parse nlmsg");
-			continue;
-		}
+	nla_nest_end(msg, linkinfo);
 
-		for (i = 0; i < ARRAY_SIZE(ifla_attrs_to_parse); ++i) {
-			int attr = ifla_attrs_to_parse[i];
-			if (ifla_tb[attr] && ifla_nla_handler[attr].cb) {
-				err = ifla_nla_handler[attr].cb(
-						attr,
-						ifla_tb[attr],
-						context);
-				if (err)
-					printf("Failed to handle %d attr", attr);
-			}
-		}
+	return 0;
+}
+
+/* Start an RTM_GETLINK (DUMMY_IFACE_CMD_GETLINK in genl mode) dump, its
+ * replies are handled like events and bring the state seen by the
+ * listener up to date.
+ */
+static void di_resync(struct dummy_iface_context *ctx)
+{
+	int err;
+	struct nl_msg *msg;
+	struct ifinfomsg ifi = { .ifi_family = AF_UNSPEC };
+	struct genlmsghdr ghdr = {
+		.cmd		= DUMMY_IFACE_CMD_GETLINK,
+		.version	= DUMMY_IFACE_GENL_VERSION,
+	};
+
+	if (ctx->dump_pending) {
+		/* A socket runs one dump at a time */
+		ctx->resync = true;
+		return;
 	}
 
-	return 0;
+	if (ctx->genl_family)
+		msg = nlmsg_alloc_simple(ctx->genl_family, NLM_F_DUMP);
+	else
+		msg = nlmsg_alloc_simple(RTM_GETLINK, NLM_F_DUMP);
+	if (!msg) {
+		ctx->resync = true;
+		return;
+	}
+
+	if (ctx->genl_family)
+		err = nlmsg_append(msg, &ghdr, sizeof(ghdr), NLMSG_ALIGNTO);
+	else
+		err = nlmsg_append(msg, &ifi, sizeof(ifi), NLMSG_ALIGNTO);
+	if (!err && ctx->kind_only)
+		err = di_put_kind_filter(msg);
+	if (!err)
+		err = nl_send_auto(ctx->sk, msg);
+	nlmsg_free(msg);
+	if (err < 0) {
+		fprintf(stderr, "Failed to request link dump: %s\n",
+				nl_geterror(err));
+		ctx->resync = true;
+		return;
+	}
+
+	ctx->dump_pending = true;
+	ctx->resync = false;
+
+	di_dump_mark(ctx, DI_MARK_DUMP_BEGIN);
 }
 
-static int di_ifla_ifname_handler(int attr, struct nlattr *nla, void *context)
+static void di_dump_done(struct dummy_iface_context *ctx)
 {
-	printf("IFLA_IFNAME: %s\n", nla_get_string(nla));
+	ctx->dump_pending = false;
+
+	/* A dump that raced with lost or interrupted parts may miss links,
+	 * only a clean one tells which cached links are gone.
+	 */
+	if (ctx->resync)
+		di_resync(ctx);
+	else
+		di_dump_mark(ctx, DI_MARK_DUMP_END);
+}
 
-	return 0;
+static int di_finish_cb(struct nl_msg *msg, void *context)
+{
+	di_dump_done(context);
+
+	return NL_STOP;
 }
 
-static int di_ifla_address_handler(int attr, struct nlattr *nla, void *context)
+/* Netlink control messages only reach us in event loop mode, libnl
+ * consumes them otherwise.
+ */
+static bool di_handle_ctrl_msg(struct nlmsghdr *hdr,
+		struct dummy_iface_context *ctx)
 {
-	uint8_t data[MAX_ADDR_LEN];
-	memcpy(data, nla_data(nla), sizeof(data));
+	switch (hdr->nlmsg_type) {
+	case NLMSG_DONE:
+		di_dump_done(ctx);
+		return true;
+	case NLMSG_ERROR: {
+		struct nlmsgerr *e = nlmsg_data(hdr);
+
+		if (e->error)
+			fprintf(stderr, "Netlink error: %s\n",
+					strerror(-e->error));
+		ctx->dump_pending = false;
+		return true;
+	}
+	case NLMSG_NOOP:
+	case NLMSG_OVERRUN:
+		return true;
+	default:
+		/* A dump part that raced with a change is inconsistent */
+		if (hdr->nlmsg_flags & NLM_F_DUMP_INTR)
+			ctx->resync = true;
+		return false;
+	}
+}
 
-	printf("IFLA_ADDRESS: %02x:%02x:%02x:%02x:%02x:%02x\n",
-			data[0], data[1], data[2],
-			data[3], data[4], data[5]);
+static void di_print_link(const struct dummy_iface_link *link)
+{
+	if (link->present & DI_LINK_IFNAME)
+		printf("IFLA_IFNAME: %s\n", link->ifname);
+	if (link->present & DI_LINK_ADDRESS)
+		printf("IFLA_ADDRESS: %02x:%02x:%02x:%02x:%02x:%02x\n",
+				link->addr[0], link->addr[1], link->addr[2],
+				link->addr[3], link->addr[4], link->addr[5]);
+	if (link->present & DI_LINK_MTU)
+		printf("IFLA_MTU: %"PRIu32"\n", link->mtu);
+	if (link->present & DI_LINK_LINK)
+		printf("IFLA_LINK: %"PRIu32"\n", link->link);
+	if (link->present & DI_LINK_KIND)
+		printf("IFLA_INFO_KIND: %s\n", link->kind);
+	if (!(link->present & DI_LINK_DATA))
+		return;
 
-	return 0;
+	printf("IFLA_INFO_DATA: \n");
+	dummy_iface_params_print(stdout, &link->params, link->params_present);
 }
 
-static int di_ifla_mtu_handler(int attr, struct nlattr *nla, void *context)
+/* A state out of the coalescing stage, the latest of @merged + 1 */
+static void di_deliver(const struct dummy_iface_link *link, uint32_t merged,
+		void *context)
 {
-	printf("IFLA_MTU: %"PRIu32"\n", nla_get_u32(nla));
+	struct dummy_iface_context *ctx = context;
 
-	return 0;
+	if (ctx->binary) {
+		dummy_iface_event_emit(&ctx->out, link);
+		return;
+	}
+
+	printf("Message:\n");
+	printf("    Type:   %s\n", rtmtostr(link->type));
+	printf("    Seq:    %"PRIu32"\n", link->seq);
+	printf("    Merged: %"PRIu32"\n\n", merged);
+	di_print_link(link);
 }
 
-static int di_ifla_link_handler(int attr, struct nlattr *nla, void *context)
+/* Decode @hdr into @link, false if it is not to be delivered. Runs on
+ * the decode workers with -t.
+ */
+static bool di_decode(struct nlmsghdr *hdr, struct dummy_iface_link *link,
+		void *context)
 {
-	printf("IFLA_LINK: %"PRIu32"\n", nla_get_u32(nla));
+	struct dummy_iface_context *ctx = context;
+	int err;
 
-	return 0;
+	if (ctx->genl_family && hdr->nlmsg_type == ctx->genl_family)
+		err = dummy_iface_link_parse_genl(hdr, link);
+	else
+		err = dummy_iface_link_parse(hdr, link);
+	if (err) {
+		fprintf(stderr, "Failed to parse nlmsg: %s\n",
+				nl_geterror(err));
+		return false;
+	}
+
+	/* RTNLGRP_LINK carries every link, and the rtnl dump is not
+	 * filtered by the kernels the module builds for: filter here.
+	 * The genl family only ever reports dummy_iface links.
+	 */
+	if (ctx->kind_only && !ctx->genl_family &&
+	    strcmp(link->kind, DUMMY_IFACE_KIND))
+		return false;
+
+	return true;
 }
 
-static int di_ifla_linkinfo_handler(int attr, struct nlattr *nla, void *context)
+/* Cache and output of a decoded message. Runs on the delivery thread
+ * with -t, the only one that touches them.
+ */
+static void di_handle_link(const struct nlmsghdr *hdr,
+		const struct dummy_iface_link *link, void *context)
 {
-	int rem;
-	struct nlattr *nla_iter;
+	struct dummy_iface_context *ctx = context;
+
+	if (ctx->cache)
+		dummy_iface_cache_update(ctx->cache, link);
 
-	nla_for_each_nested(nla_iter, nla, rem) {
-		int attr = nla_type(nla_iter);
-		if (ifla_info_nla_handler[attr].cb)
-			ifla_info_nla_handler[attr].cb(attr, nla_iter, context);
+	if (ctx->coalesce) {
+		dummy_iface_coalesce_add(ctx->coalesce, link);
+		return;
 	}
 
-	return 0;
+	if (ctx->binary) {
+		dummy_iface_event_emit(&ctx->out, link);
+		return;
+	}
+
+	printf("Message:\n");
+	printf("    Type:  %s\n", rtmtostr(link->type));
+	printf("    PID:   %"PRIu32"\n", hdr->nlmsg_pid);
+	printf("    Len:   %"PRIu32"\n", hdr->nlmsg_len);
+	printf("    Seq:   %"PRIu32"\n", hdr->nlmsg_seq);
+	printf("    Flags: %"PRIu32"\n\n", hdr->nlmsg_flags);
+	di_print_link(link);
 }
 
-static int di_ifla_info_kind_handler(int attr, struct nlattr *nla, void *context)
+static void di_cache_mark(uint32_t mark, void *context)
 {
-	printf("IFLA_INFO_KIND: %s\n", nla_get_string(nla));
+	struct dummy_iface_context *ctx = context;
 
-	return 0;
+	if (mark == DI_MARK_DUMP_BEGIN)
+		dummy_iface_cache_dump_begin(ctx->cache);
+	else
+		dummy_iface_cache_dump_end(ctx->cache);
 }
 
-static int di_ifla_info_data_handler(int attr, struct nlattr *nla, void *context)
+static void di_dump_mark(struct dummy_iface_context *ctx, uint32_t mark)
 {
-	printf("IFLA_INFO_DATA: \n");
+	if (!ctx->cache)
+		return;
 
-	return 0;
+	if (ctx->pipeline)
+		dummy_iface_pipeline_mark(ctx->pipeline, mark);
+	else
+		di_cache_mark(mark, ctx);
 }
 
-static int di_ifla_di_attr_0_handler(int attr, struct nlattr *nla, void *context)
+/* Pending output, and the milliseconds until the next coalescing window
+ * expires (-1: none)
+ */
+static int di_idle(void *context)
 {
-	return 0;
+	struct dummy_iface_context *ctx = context;
+	int timeout = -1;
+
+	if (ctx->coalesce)
+		timeout = dummy_iface_coalesce_run(ctx->coalesce);
+
+	dummy_iface_event_flush(&ctx->out);
+	fflush(stdout);
+
+	return timeout;
 }
 
-static int di_ifla_di_attr_1_handler(int attr, struct nlattr *nla, void *context)
+static const struct dummy_iface_pipeline_ops di_pipeline_ops = {
+	.decode		= di_decode,
+	.deliver	= di_handle_link,
+	.mark		= di_cache_mark,
+	.idle		= di_idle,
+};
+
+/* The worker of a message: its ifindex, read without decoding it */
+static int32_t di_msg_ifindex(struct dummy_iface_context *ctx,
+		struct nlmsghdr *hdr)
 {
-	return 0;
+	struct nlattr *nla;
+	int rem;
+
+	if (ctx->genl_family && hdr->nlmsg_type == ctx->genl_family) {
+		if (hdr->nlmsg_len < NLMSG_LENGTH(GENL_HDRLEN))
+			return 0;
+		di_nlmsg_for_each_attr(nla, hdr, GENL_HDRLEN, rem)
+			if (di_nla_type(nla) == DUMMY_IFACE_A_IFINDEX &&
+			    di_nla_len(nla) >= sizeof(int32_t))
+				return *(int32_t *)di_nla_data(nla);
+		return 0;
+	}
+
+	if (hdr->nlmsg_len < NLMSG_LENGTH(sizeof(struct ifinfomsg)))
+		return 0;
+
+	return ((struct ifinfomsg *)NLMSG_DATA(hdr))->ifi_index;
 }
 
-static int di_ifla_di_attr_2_handler(int attr, struct nlattr *nla, void *context)
+static void di_handle_stream(struct nlmsghdr *stream, int rem, void *context)
 {
-	return 0;
+	struct nlmsghdr *hdr;
+	struct dummy_iface_context *ctx = context;
+
+	for (hdr = stream; nlmsg_ok(hdr, rem); hdr = nlmsg_next(hdr, &rem)) {
+		if (di_handle_ctrl_msg(hdr, context))
+			continue;
+
+		if (ctx->pipeline)
+			dummy_iface_pipeline_push(ctx->pipeline, ctx->rx_buf,
+					hdr, di_msg_ifindex(ctx, hdr));
+		else if (di_decode(hdr, &ctx->link, ctx))
+			di_handle_link(hdr, &ctx->link, ctx);
+	}
 }
 
-static int di_ifla_di_attr_nest_handler(int attr, struct nlattr *nla, void *context)
+static void di_set_rcvbuf(int fd, int size)
 {
-	return 0;
+	/* SO_RCVBUFFORCE ignores net.core.rmem_max but needs CAP_NET_ADMIN */
+	if (!setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)))
+		return;
+
+	if (setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)))
+		perror("Failed to set socket receive buffer");
 }
 
-static int di_ifla_di_attr_bin_handler(int attr, struct nlattr *nla, void *context)
+/* Read everything the socket holds, DI_RX_BATCH datagrams per syscall.
+ * An overrun (ENOBUFS) means events were lost: resync with a dump.
+ */
+static int di_drain(struct dummy_iface_context *ctx, int fd)
 {
-	return 0;
+	struct dummy_iface_buf *bufs[DI_RX_BATCH];
+	struct iovec iov[DI_RX_BATCH];
+	struct mmsghdr msgs[DI_RX_BATCH];
+	int i, n, err = 0;
+
+	memset(msgs, 0, sizeof(msgs));
+	for (i = 0; i < DI_RX_BATCH; ++i) {
+		bufs[i] = dummy_iface_bufpool_get(ctx->pool);
+		iov[i].iov_base = bufs[i]->data;
+		iov[i].iov_len = ctx->pool->size;
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	while (true) {
+		n = recvmmsg(fd, msgs, DI_RX_BATCH, MSG_DONTWAIT, NULL);
+		if (n < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			if (errno == EINTR)
+				continue;
+			if (errno == ENOBUFS) {
+				ctx->overruns++;
+				fprintf(stderr, "Socket overrun (%lu), resync\n",
+						ctx->overruns);
+				di_resync(ctx);
+				continue;
+			}
+			perror("Failed to receive");
+			err = -1;
+			break;
+		}
+
+		for (i = 0; i < n; ++i) {
+			if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+				fprintf(stderr, "Truncated message, resync\n");
+				di_resync(ctx);
+				continue;
+			}
+			ctx->rx_buf = bufs[i];
+			di_handle_stream((struct nlmsghdr *)bufs[i]->data,
+					msgs[i].msg_len, ctx);
+
+			/* Still read by a worker: receive into another one */
+			if (dummy_iface_buf_shared(bufs[i])) {
+				dummy_iface_buf_put(bufs[i]);
+				bufs[i] = dummy_iface_bufpool_get(ctx->pool);
+				iov[i].iov_base = bufs[i]->data;
+			}
+		}
+
+		/* A short batch drained the socket */
+		if (n < DI_RX_BATCH)
+			break;
+	}
+
+	for (i = 0; i < DI_RX_BATCH; ++i)
+		dummy_iface_buf_put(bufs[i]);
+
+	return err;
+}
+
+static int di_event_loop(struct dummy_iface_context *ctx)
+{
+	int n, timeout, epfd, fd = nl_socket_get_fd(ctx->sk);
+	struct epoll_event ev = { .events = EPOLLIN };
+
+	nl_socket_disable_auto_ack(ctx->sk);
+
+	if (nl_socket_set_nonblocking(ctx->sk) < 0) {
+		fprintf(stderr, "Failed to make socket non-blocking\n");
+		return -1;
+	}
+
+	di_set_rcvbuf(fd, ctx->rcvbuf);
+
+	epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (epfd < 0) {
+		perror("Failed to create epoll instance");
+		return -1;
+	}
+
+	if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev)) {
+		perror("Failed to add socket to epoll");
+		close(epfd);
+		return -1;
+	}
+
+	/* Start from the current state, events only tell the changes */
+	di_resync(ctx);
+
+	while (true) {
+		/* Wake up for the next coalescing window to expire too,
+		 * the delivery thread takes care of it with -t
+		 */
+		timeout = -1;
+		if (!ctx->pipeline)
+			timeout = di_idle(ctx);
+
+		n = epoll_wait(epfd, &ev, 1, timeout);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("Failed to wait for events");
+			break;
+		}
+
+		if (n && di_drain(ctx, fd))
+			break;
+	}
+
+	close(epfd);
+
+	return -1;
 }
 
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [-e] [-g | -k] [-r bytes] [-b file | -s name] [-c name]\n"
+		"          [-W ms [-Q depth]] [-t workers]\n"
+		"  -e        event loop mode: epoll, batched receive, resync on overrun\n"
+		"  -g        dummy_iface devices only, from the module's genl family\n"
+		"  -k        dummy_iface devices only, from rtnetlink\n"
+		"  -r bytes  socket receive buffer in event loop mode (default %d)\n"
+		"  -b file   write binary event records to file ('-' for stdout)\n"
+		"  -s name   write binary event records to shared memory ring name\n"
+		"  -c name   keep a link state cache in shared memory name\n"
+		"  -W ms     coalesce the events of a link for ms, only its latest\n"
+		"            state is delivered (implies -e)\n"
+		"  -Q depth  states a link queues in a window (default 1)\n"
+		"  -t n      decode on n worker threads, sharded by ifindex, and\n"
+		"            deliver on another one (implies -e)\n",
+		prog, DI_DEFAULT_RCVBUF);
+}
 
 int main(int argc, char *argv[])
 {
-	int err = 0;
+	int opt, err = 0, group, window = -1, depth = 1, workers = 0;
+	bool event_loop = false, genl = false;
 	struct nl_sock *sk;
 	struct dummy_iface_context di_context;
 
+	memset(&di_context, 0, sizeof(di_context));
+	di_context.rcvbuf = DI_DEFAULT_RCVBUF;
+
+	while ((opt = getopt(argc, argv, "egkr:b:s:c:W:Q:t:h")) != -1) {
+		switch (opt) {
+		case 'e':
+			event_loop = true;
+			break;
+		case 'g':
+			genl = true;
+			break;
+		case 'k':
+			di_context.kind_only = true;
+			break;
+		case 'r':
+			di_context.rcvbuf = atoi(optarg);
+			break;
+		case 'b':
+		case 's':
+			if (di_context.binary) {
+				usage(argv[0]);
+				return 1;
+			}
+			if (opt == 'b')
+				err = dummy_iface_event_stream_open(
+						&di_context.out, optarg);
+			else
+				err = dummy_iface_event_ring_open(
+						&di_context.out, optarg,
+						DUMMY_IFACE_RING_CAPACITY);
+			if (err)
+				return 1;
+			di_context.binary = true;
+			break;
+		case 'W':
+			window = atoi(optarg);
+			event_loop = true;
+			break;
+		case 'Q':
+			depth = atoi(optarg);
+			break;
+		case 't':
+			workers = atoi(optarg);
+			event_loop = true;
+			break;
+		case 'c':
+			di_context.cache = dummy_iface_cache_open(optarg,
+					DUMMY_IFACE_CACHE_CAPACITY);
+			if (!di_context.cache)
+				return 1;
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (window >= 0) {
+		di_context.coalesce = dummy_iface_coalesce_create(window, depth,
+				DUMMY_IFACE_COALESCE_CAPACITY, di_deliver,
+				&di_context);
+		if (!di_context.coalesce)
+			return 1;
+	}
+
 	sk = nl_socket_alloc();
 
 	di_context.sk = sk;
@@ -263,24 +647,85 @@ int main(int argc, char *argv[])
 		goto free_hdl;
 	}
 
-	err = nl_connect(sk, NETLINK_ROUTE);
+	err = nl_socket_modify_cb(sk, NL_CB_FINISH, NL_CB_CUSTOM,
+			di_finish_cb, &di_context);
 	if (err) {
-		perror("Failed to connect to NETLINK_ROUTE");
+		perror("Failed to add callback");
 		goto free_hdl;
 	}
 
-	err = nl_socket_add_membership(sk, RTNLGRP_LINK);
+	err = nl_connect(sk, genl ? NETLINK_GENERIC : NETLINK_ROUTE);
+	if (err) {
+		perror("Failed to connect to netlink");
+		goto free_hdl;
+	}
+
+	if (genl) {
+		err = dummy_iface_genl_resolve(sk, &di_context.genl_family,
+				&group);
+		if (err) {
+			fprintf(stderr, "Failed to resolve %s family: %s\n",
+					DUMMY_IFACE_GENL_NAME, nl_geterror(err));
+			goto free_hdl;
+		}
+	} else {
+		group = RTNLGRP_LINK;
+	}
+
+	err = nl_socket_add_membership(sk, group);
 	if (err) {
 		perror("Failed subscribe to link notification group");
 		goto free_hdl;
 	}
 
+	if (event_loop) {
+		di_context.pool = dummy_iface_bufpool_create(DI_RX_POOL,
+				DI_RX_BUF_SIZE);
+		if (!di_context.pool) {
+			err = -1;
+			goto free_hdl;
+		}
+	}
+
+	if (workers) {
+		di_context.pipeline = dummy_iface_pipeline_start(workers,
+				&di_pipeline_ops, &di_context);
+		if (!di_context.pipeline) {
+			err = -1;
+			goto free_hdl;
+		}
+	}
+
+	if (event_loop) {
+		err = di_event_loop(&di_context);
+		goto free_hdl;
+	}
+
+	/* The cache starts from the current state */
+	if (di_context.cache)
+		di_resync(&di_context);
+
 	while (true) {
-		nl_recvmsgs_default(sk);
+		err = nl_recvmsgs_default(sk);
+		if (di_context.cache &&
+		    (err == -NLE_DUMP_INTR || err == -NLE_NOMEM)) {
+			/* Interrupted dump or socket overrun */
+			di_context.resync = true;
+			if (!di_context.dump_pending)
+				di_resync(&di_context);
+		}
+		dummy_iface_event_flush(&di_context.out);
 	}
 
 free_hdl:
 	nl_socket_free(sk);
+	dummy_iface_pipeline_stop(di_context.pipeline);
+	dummy_iface_bufpool_destroy(di_context.pool);
+	if (di_context.coalesce)
+		dummy_iface_coalesce_flush(di_context.coalesce);
+	dummy_iface_coalesce_destroy(di_context.coalesce);
+	dummy_iface_event_close(&di_context.out);
+	dummy_iface_cache_close(di_context.cache);
 
 	return err;
 }